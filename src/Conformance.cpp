@@ -0,0 +1,252 @@
+#define SDL_MAIN_HANDLED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Display.h"
+#include "Hash.h"
+#include "Keypad.h"
+#include "Processor.h"
+
+// Golden values are kept per quirk profile, since quirks change the results
+#ifdef ORIGINAL_CHIP8
+static const std::string PROFILE = "original";
+#else
+static const std::string PROFILE = "modern";
+#endif
+
+static const unsigned int RANDOM_SEED = 0xC8;
+
+struct TestCase {
+  // As written in the manifest, and resolved against the manifest directory
+  std::string manifest_rom_path;
+  std::string rom_path;
+  uint64_t cycles;
+  uint64_t expected_framebuffer_hash;
+  uint64_t expected_register_hash;
+};
+
+struct TestResult {
+  bool is_passed = false;
+  uint64_t framebuffer_hash = 0;
+  uint64_t register_hash = 0;
+  Processor::Trap trap = Processor::Trap::NONE;
+  std::string error;
+};
+
+static uint64_t hashFramebuffer(Display& display) {
+  const uint32_t* pixels = display.getPixels();
+  uint64_t hash = FNV_OFFSET_BASIS;
+
+  // Hash on/off state rather than colours so golden values outlive the
+  // surface format
+  for (std::size_t i = 0; i < display.getSize(); i++) {
+    uint8_t is_on = pixels[i] != 0;
+    hash = hashBytes(hash, &is_on, 1);
+  }
+
+  return hash;
+}
+
+static uint64_t hashRegisters(const Processor& processor) {
+  Processor::Address program_counter = processor.getProgramCounter();
+  Processor::IndexRegisterValue index_register = processor.getIndexRegister();
+  Processor::Timer delay_timer = processor.getDelayTimer();
+  Processor::Timer sound_timer = processor.getSoundTimer();
+  Processor::Trap trap = processor.getTrap();
+
+  uint64_t hash = FNV_OFFSET_BASIS;
+  hash = hashBytes(hash, processor.getRegisters(), 16);
+  hash = hashBytes(hash, &program_counter, sizeof(program_counter));
+  hash = hashBytes(hash, &index_register, sizeof(index_register));
+  hash = hashBytes(hash, &delay_timer, sizeof(delay_timer));
+  hash = hashBytes(hash, &sound_timer, sizeof(sound_timer));
+  // Expected traps are part of the golden values, so a ROM can test them
+  hash = hashBytes(hash, &trap, sizeof(trap));
+
+  return hash;
+}
+
+static TestResult runTestCase(const TestCase& test_case) {
+  TestResult result;
+
+  if (!std::filesystem::exists(test_case.rom_path)) {
+    result.error = "ROM not found";
+    return result;
+  }
+
+  try {
+    Keypad keypad;
+    Display display{1, true};
+    Processor processor{test_case.rom_path, display, keypad};
+    processor.seedRandom(RANDOM_SEED);
+
+    for (uint64_t cycle = 0; cycle < test_case.cycles; cycle++) {
+      processor.process();
+    }
+
+    result.framebuffer_hash = hashFramebuffer(display);
+    result.register_hash = hashRegisters(processor);
+    result.trap = processor.getTrap();
+  } catch (const std::exception& exception) {
+    result.error = exception.what();
+    return result;
+  }
+
+  result.is_passed =
+      result.framebuffer_hash == test_case.expected_framebuffer_hash &&
+      result.register_hash == test_case.expected_register_hash;
+  return result;
+}
+
+// Manifest lines are: <profile> <rom path> <cycles> <framebuffer hash>
+// <register hash>. ROM paths are relative to the manifest, and lines for
+// other profiles or starting with # are skipped. A manifest that is missing,
+// malformed or has no lines for this profile throws, so a gate never passes
+// without running anything.
+static std::vector<TestCase> readManifest(const std::string& manifest_path) {
+  std::vector<TestCase> test_cases;
+  std::filesystem::path base_path =
+      std::filesystem::path{manifest_path}.parent_path();
+
+  std::ifstream manifest{manifest_path};
+  if (!manifest) {
+    throw std::runtime_error("Could not open manifest " + manifest_path);
+  }
+
+  std::string line;
+  std::size_t line_number = 0;
+  while (std::getline(manifest, line)) {
+    line_number++;
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream tokens{line};
+    std::string profile, rom_path, extra;
+    TestCase test_case{};
+    tokens >> profile >> rom_path >> test_case.cycles >> std::hex >>
+        test_case.expected_framebuffer_hash >> test_case.expected_register_hash;
+
+    if (tokens.fail() || tokens >> extra) {
+      throw std::runtime_error(std::format(
+          "{}:{}: expected <profile> <rom path> <cycles> <framebuffer hash> "
+          "<register hash>",
+          manifest_path, line_number));
+    }
+
+    if (profile != PROFILE) continue;
+
+    test_case.manifest_rom_path = rom_path;
+    test_case.rom_path = (base_path / rom_path).string();
+    test_cases.push_back(test_case);
+  }
+
+  if (test_cases.empty()) {
+    throw std::runtime_error(std::format("{} has no {} test cases",
+                                         manifest_path, PROFILE));
+  }
+
+  return test_cases;
+}
+
+int main(int argc, char* argv[]) {
+  std::string manifest_path;
+  bool is_recording = false;
+  unsigned int job_count = std::max(1u, std::thread::hardware_concurrency());
+
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+
+    if (argument == "--record") {
+      is_recording = true;
+    } else if (argument == "--jobs" && i + 1 < argc) {
+      job_count = std::max(1, std::stoi(argv[++i]));
+    } else {
+      manifest_path = argument;
+    }
+  }
+
+  if (manifest_path.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " <manifest> [--record] [--jobs N]\n";
+    return -1;
+  }
+
+  std::vector<TestCase> test_cases;
+  try {
+    test_cases = readManifest(manifest_path);
+  } catch (const std::exception& exception) {
+    std::cerr << exception.what() << "\n";
+    return -1;
+  }
+
+  std::vector<TestResult> results(test_cases.size());
+  std::atomic<std::size_t> next_test_case{0};
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < job_count; i++) {
+    workers.emplace_back([&]() {
+      for (std::size_t index = next_test_case++; index < test_cases.size();
+           index = next_test_case++) {
+        results[index] = runTestCase(test_cases[index]);
+      }
+    });
+  }
+
+  for (std::thread& worker : workers) worker.join();
+
+  auto time_taken = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start_time);
+
+  std::size_t failure_count = 0;
+  for (std::size_t i = 0; i < test_cases.size(); i++) {
+    const TestCase& test_case = test_cases[i];
+    const TestResult& result = results[i];
+
+    if (is_recording) {
+      std::cout << std::format("{} {} {} {:016x} {:016x}\n", PROFILE,
+                               test_case.manifest_rom_path, test_case.cycles,
+                               result.framebuffer_hash, result.register_hash);
+      continue;
+    }
+
+    if (result.is_passed) continue;
+
+    failure_count++;
+    if (!result.error.empty()) {
+      std::cout << std::format("FAIL {}: {}\n", test_case.rom_path,
+                               result.error);
+    } else if (result.trap != Processor::Trap::NONE) {
+      std::cout << std::format("FAIL {}: trapped with {}\n",
+                               test_case.rom_path,
+                               Processor::getTrapName(result.trap));
+    } else {
+      std::cout << std::format(
+          "FAIL {}: framebuffer {:016x} (expected {:016x}), registers {:016x} "
+          "(expected {:016x})\n",
+          test_case.rom_path, result.framebuffer_hash,
+          test_case.expected_framebuffer_hash, result.register_hash,
+          test_case.expected_register_hash);
+    }
+  }
+
+  if (is_recording) return 0;
+
+  std::cout << std::format("{}: {}/{} passed in {} ms\n", PROFILE,
+                           test_cases.size() - failure_count,
+                           test_cases.size(), time_taken.count());
+  return failure_count == 0 ? 0 : 1;
+}
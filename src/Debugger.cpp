@@ -0,0 +1,521 @@
+#include "Debugger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "Memory.h"
+#include "Processor.h"
+
+static const Debugger::Address CALL_INSTRUCTION_TYPE = 0x2;
+static const std::size_t DEFAULT_DISASSEMBLY_COUNT = 8;
+static const std::size_t DEFAULT_MEMORY_DUMP_COUNT = 16;
+
+static Debugger::Address parseAddress(const std::string& token) {
+  return std::stoul(token, nullptr, 0) & 0xFFF;
+}
+
+static uint16_t parseRegister(const std::string& token) {
+  if (token.size() != 2 || (token[0] != 'V' && token[0] != 'v')) {
+    throw std::invalid_argument("Register should be of the form Vx");
+  }
+
+  return std::stoul(token.substr(1), nullptr, 16);
+}
+
+static Debugger::RegisterValue parseValue(const std::string& token) {
+  unsigned long value = std::stoul(token, nullptr, 0);
+  if (value > 0xFF) {
+    throw std::invalid_argument("Value should be between 0x00 and 0xFF");
+  }
+
+  return value;
+}
+
+static Debugger::Comparison parseComparison(const std::string& token) {
+  if (token == "==") return Debugger::Comparison::EQUAL;
+  if (token == "!=") return Debugger::Comparison::NOT_EQUAL;
+  if (token == "<") return Debugger::Comparison::LESS;
+  if (token == "<=") return Debugger::Comparison::LESS_EQUAL;
+  if (token == ">") return Debugger::Comparison::GREATER;
+  if (token == ">=") return Debugger::Comparison::GREATER_EQUAL;
+
+  throw std::invalid_argument("Unknown comparison " + token);
+}
+
+Debugger::Debugger(Processor& processor)
+    : processor{processor},
+      step_mode{StepMode::NONE},
+      step_target{0x0},
+      step_depth{0},
+      is_trap_pending{false},
+      watch_hits{} {
+  this->initializeDisassemblers();
+}
+
+void Debugger::initializeDisassemblers() {
+  std::fill_n(this->disassembly_table, 0x10, &Debugger::disassembleNoop);
+
+  this->disassembly_table[0x0] = &Debugger::disassemble0;
+  this->disassembly_table[0x1] = &Debugger::disassembleJump;
+  this->disassembly_table[0x2] = &Debugger::disassembleCall;
+  this->disassembly_table[0x3] = &Debugger::disassembleConstantSkip;
+  this->disassembly_table[0x4] = &Debugger::disassembleConstantSkip;
+  this->disassembly_table[0x5] = &Debugger::disassembleRegisterSkip;
+  this->disassembly_table[0x6] = &Debugger::disassembleSetRegister;
+  this->disassembly_table[0x7] = &Debugger::disassembleAddToRegister;
+  this->disassembly_table[0x8] = &Debugger::disassembleArithmetic;
+  this->disassembly_table[0x9] = &Debugger::disassembleRegisterSkip;
+  this->disassembly_table[0xA] = &Debugger::disassembleSetIndex;
+  this->disassembly_table[0xB] = &Debugger::disassembleJumpWithOffset;
+  this->disassembly_table[0xC] = &Debugger::disassembleRandom;
+  this->disassembly_table[0xD] = &Debugger::disassembleDraw;
+  this->disassembly_table[0xE] = &Debugger::disassembleSkipIfKey;
+  this->disassembly_table[0xF] = &Debugger::disassembleF;
+
+  std::fill_n(this->arithmetic_mnemonics, 0x10, nullptr);
+
+  this->arithmetic_mnemonics[0x0] = "LD";
+  this->arithmetic_mnemonics[0x1] = "OR";
+  this->arithmetic_mnemonics[0x2] = "AND";
+  this->arithmetic_mnemonics[0x3] = "XOR";
+  this->arithmetic_mnemonics[0x4] = "ADD";
+  this->arithmetic_mnemonics[0x5] = "SUB";
+  this->arithmetic_mnemonics[0x6] = "SHR";
+  this->arithmetic_mnemonics[0x7] = "SUBN";
+  this->arithmetic_mnemonics[0xE] = "SHL";
+}
+
+void Debugger::addBreakpoint(const Address address) {
+  this->breakpoints.set(address);
+  this->conditions.erase(address);
+}
+
+void Debugger::addConditionalBreakpoint(const Address address,
+                                        const uint16_t register_to_check,
+                                        const Comparison comparison,
+                                        const RegisterValue value) {
+  // An unconditional breakpoint at the same address already always triggers
+  if (this->breakpoints.test(address) && !this->conditions.contains(address)) {
+    return;
+  }
+
+  this->breakpoints.set(address);
+  this->conditions[address].push_back({register_to_check, comparison, value});
+}
+
+void Debugger::removeBreakpoint(const Address address) {
+  this->breakpoints.reset(address);
+  this->conditions.erase(address);
+}
+
+void Debugger::addWatchpoint(const Address address) {
+  this->watchpoints.set(address);
+  this->watched_pages.set(address / Memory::PAGE_SIZE);
+}
+
+void Debugger::removeWatchpoint(const Address address) {
+  this->watchpoints.reset(address);
+
+  std::size_t page = address / Memory::PAGE_SIZE;
+  for (std::size_t i = 0; i < Memory::PAGE_SIZE; i++) {
+    if (this->watchpoints.test(page * Memory::PAGE_SIZE + i)) return;
+  }
+
+  this->watched_pages.reset(page);
+}
+
+void Debugger::pause() { this->step_mode = StepMode::STEP; }
+
+void Debugger::onMemoryWrite(const Address address) {
+  if (!this->watched_pages.test(address / Memory::PAGE_SIZE)) return;
+  if (!this->watchpoints.test(address)) return;
+
+  this->watch_hits.push_back(address);
+}
+
+void Debugger::onTrap() { this->is_trap_pending = true; }
+
+bool Debugger::shouldBreak() {
+  Address program_counter = this->processor.program_counter;
+
+  if (this->is_trap_pending) {
+    this->is_trap_pending = false;
+    std::cout << std::format(
+        "Trap: {} at 0x{:03X}\n",
+        Processor::getTrapName(this->processor.getTrap()),
+        this->processor.getTrapAddress());
+    return true;
+  }
+
+  if (!this->watch_hits.empty()) {
+    for (Address address : this->watch_hits) {
+      std::cout << std::format("Watchpoint hit: 0x{:03X} = 0x{:02X}\n",
+                               address, this->processor.memory.read(address));
+    }
+    this->watch_hits.clear();
+    return true;
+  }
+
+  // Nothing runs until the machine is resumed, so stay at the prompt
+  if (this->processor.is_halted) return true;
+
+  switch (this->step_mode) {
+    case StepMode::NONE:
+      break;
+
+    case StepMode::STEP:
+      return true;
+
+    case StepMode::STEP_OVER:
+      if (program_counter == this->step_target &&
+          this->processor.stack_pointer == this->step_depth) {
+        return true;
+      }
+      break;
+
+    case StepMode::STEP_OUT:
+      if (this->processor.stack_pointer < this->step_depth) return true;
+      break;
+  }
+
+  if (!this->breakpoints.test(program_counter)) return false;
+
+  auto iter = this->conditions.find(program_counter);
+  if (iter == this->conditions.end()) return true;
+
+  return std::any_of(
+      iter->second.cbegin(), iter->second.cend(),
+      [this](const Condition& condition) {
+        return this->isConditionMet(condition);
+      });
+}
+
+bool Debugger::isConditionMet(const Condition& condition) const {
+  RegisterValue value = this->processor.registers[condition.register_to_check];
+
+  switch (condition.comparison) {
+    case Comparison::EQUAL:
+      return value == condition.value;
+    case Comparison::NOT_EQUAL:
+      return value != condition.value;
+    case Comparison::LESS:
+      return value < condition.value;
+    case Comparison::LESS_EQUAL:
+      return value <= condition.value;
+    case Comparison::GREATER:
+      return value > condition.value;
+    case Comparison::GREATER_EQUAL:
+      return value >= condition.value;
+  }
+
+  return false;
+}
+
+bool Debugger::startStepOver() {
+  Address program_counter = this->processor.program_counter;
+  if (program_counter > Memory::SIZE - 2) {
+    this->step_mode = StepMode::STEP;
+    return true;
+  }
+
+  Instruction instruction = this->readInstruction(program_counter);
+
+  // Anything other than a call behaves the same as a single step
+  if ((instruction >> 12) != CALL_INSTRUCTION_TYPE) {
+    this->step_mode = StepMode::STEP;
+    return true;
+  }
+
+  this->step_mode = StepMode::STEP_OVER;
+  this->step_target = program_counter + 2;
+  this->step_depth = this->processor.stack_pointer;
+  return true;
+}
+
+bool Debugger::startStepOut() {
+  if (this->processor.stack_pointer == 0) {
+    std::cout << "Not inside a subroutine\n";
+    return false;
+  }
+
+  this->step_mode = StepMode::STEP_OUT;
+  this->step_depth = this->processor.stack_pointer;
+  return true;
+}
+
+bool Debugger::resume() {
+  if (!this->processor.is_halted) {
+    std::cout << "Not halted\n";
+    return false;
+  }
+
+  // Carry on past the faulting instruction, as the ignore policy would
+  Address next_address = this->processor.trap_address + 2;
+  this->processor.clearTrap();
+  this->processor.program_counter = next_address;
+  return true;
+}
+
+bool Debugger::prompt() {
+  this->step_mode = StepMode::NONE;
+  this->printDisassembly(this->processor.program_counter, 1);
+  if (this->processor.is_halted) {
+    std::cout << "Halted, resume continues past the trap\n";
+  }
+
+  std::string line;
+  while (std::cout << "(chip8) " << std::flush &&
+         std::getline(std::cin, line)) {
+    std::istringstream tokens{line};
+    std::string command;
+    tokens >> command;
+
+    try {
+      if (command == "c" || command == "continue") {
+        return false;
+      } else if (command == "s" || command == "step") {
+        this->step_mode = StepMode::STEP;
+        return false;
+      } else if (command == "n" || command == "next") {
+        if (this->startStepOver()) return false;
+      } else if (command == "f" || command == "finish") {
+        if (this->startStepOut()) return false;
+      } else if (command == "b" || command == "break") {
+        std::string address, keyword, register_x, comparison, value;
+        tokens >> address >> keyword >> register_x >> comparison >> value;
+
+        if (keyword.empty()) {
+          this->addBreakpoint(parseAddress(address));
+        } else if (keyword == "if") {
+          this->addConditionalBreakpoint(
+              parseAddress(address), parseRegister(register_x),
+              parseComparison(comparison), parseValue(value));
+        } else {
+          throw std::invalid_argument("Expected: break ADDR [if Vx OP NN]");
+        }
+      } else if (command == "d" || command == "delete") {
+        std::string address;
+        tokens >> address;
+        this->removeBreakpoint(parseAddress(address));
+      } else if (command == "w" || command == "watch") {
+        std::string address;
+        tokens >> address;
+        this->addWatchpoint(parseAddress(address));
+      } else if (command == "unwatch") {
+        std::string address;
+        tokens >> address;
+        this->removeWatchpoint(parseAddress(address));
+      } else if (command == "resume") {
+        if (this->resume()) return false;
+      } else if (command == "r" || command == "regs") {
+        this->printRegisters();
+      } else if (command == "x") {
+        std::string address, count;
+        tokens >> address >> count;
+        this->printMemory(parseAddress(address),
+                          count.empty() ? DEFAULT_MEMORY_DUMP_COUNT
+                                        : std::stoul(count, nullptr, 0));
+      } else if (command == "l" || command == "disas") {
+        std::string address, count;
+        tokens >> address >> count;
+        this->printDisassembly(
+            address.empty() ? this->processor.program_counter
+                            : parseAddress(address),
+            count.empty() ? DEFAULT_DISASSEMBLY_COUNT
+                          : std::stoul(count, nullptr, 0));
+      } else if (command == "q" || command == "quit") {
+        return true;
+      } else if (!command.empty()) {
+        std::cout << "Commands: continue, step, next, finish, resume, "
+                     "break ADDR [if Vx OP NN], delete ADDR, watch ADDR, "
+                     "unwatch ADDR, regs, x ADDR [N], disas [ADDR] [N], quit\n";
+      }
+    } catch (const std::exception& exception) {
+      std::cout << "Invalid command: " << exception.what() << "\n";
+    }
+  }
+
+  // Input was closed, so there is no one left to drive the debugger
+  return true;
+}
+
+void Debugger::printRegisters() const {
+  for (uint16_t i = 0; i < 16; i++) {
+    std::cout << std::format("V{:X}=0x{:02X}{}", i,
+                             this->processor.registers[i],
+                             i % 8 == 7 ? "\n" : " ");
+  }
+
+  std::cout << std::format(
+      "PC=0x{:03X} I=0x{:03X} DT=0x{:02X} ST=0x{:02X} SP={}\n",
+      this->processor.program_counter, this->processor.index_register,
+      this->processor.delay_timer, this->processor.sound_timer,
+      this->processor.stack_pointer);
+
+  if (this->processor.trap != Processor::Trap::NONE) {
+    std::cout << std::format("Trap: {} at 0x{:03X}\n",
+                             Processor::getTrapName(this->processor.trap),
+                             this->processor.trap_address);
+  }
+}
+
+void Debugger::printMemory(const Address address,
+                           const std::size_t count) const {
+  for (std::size_t i = 0; i < count && address + i < Memory::SIZE; i++) {
+    if (i % 16 == 0) std::cout << std::format("0x{:03X}:", address + i);
+    std::cout << std::format(" {:02X}",
+                             this->processor.memory.read(address + i));
+    if (i % 16 == 15 || i + 1 == count) std::cout << "\n";
+  }
+}
+
+void Debugger::printDisassembly(const Address address,
+                                const std::size_t count) const {
+  for (std::size_t i = 0; i < count; i++) {
+    std::size_t current = address + 2 * i;
+    if (current + 1 >= Memory::SIZE) break;
+
+    Instruction instruction = this->readInstruction(current);
+    std::cout << std::format(
+        "{} 0x{:03X}: {:04X}  {}\n",
+        current == this->processor.program_counter ? "=>" : "  ", current,
+        instruction, this->disassemble(instruction));
+  }
+}
+
+Debugger::Instruction Debugger::readInstruction(const Address address) const {
+  return (this->processor.memory.read(address) << 8) |
+         this->processor.memory.read(address + 1);
+}
+
+std::string Debugger::disassemble(const Instruction& instruction) const {
+  uint16_t first_nibble = instruction >> 12;
+  return (this->*disassembly_table[first_nibble])(instruction);
+}
+
+std::string Debugger::disassembleNoop(const Instruction& instruction) const {
+  return std::format("DW 0x{:04X}", instruction);
+}
+
+std::string Debugger::disassemble0(const Instruction& instruction) const {
+  if (instruction == 0x00E0) return "CLS";
+  if (instruction == 0x00EE) return "RET";
+
+  return std::format("SYS 0x{:03X}", instruction & 0xFFF);
+}
+
+std::string Debugger::disassembleJump(const Instruction& instruction) const {
+  return std::format("JP 0x{:03X}", instruction & 0xFFF);
+}
+
+std::string Debugger::disassembleCall(const Instruction& instruction) const {
+  return std::format("CALL 0x{:03X}", instruction & 0xFFF);
+}
+
+std::string Debugger::disassembleConstantSkip(
+    const Instruction& instruction) const {
+  return std::format("{} V{:X}, 0x{:02X}",
+                     (instruction >> 12) == 0x3 ? "SE" : "SNE",
+                     (instruction & 0xF00) >> 8, instruction & 0xFF);
+}
+
+std::string Debugger::disassembleRegisterSkip(
+    const Instruction& instruction) const {
+  if ((instruction & 0xF) != 0) return this->disassembleNoop(instruction);
+
+  return std::format("{} V{:X}, V{:X}",
+                     (instruction >> 12) == 0x5 ? "SE" : "SNE",
+                     (instruction & 0xF00) >> 8, (instruction & 0xF0) >> 4);
+}
+
+std::string Debugger::disassembleSetRegister(
+    const Instruction& instruction) const {
+  return std::format("LD V{:X}, 0x{:02X}", (instruction & 0xF00) >> 8,
+                     instruction & 0xFF);
+}
+
+std::string Debugger::disassembleAddToRegister(
+    const Instruction& instruction) const {
+  return std::format("ADD V{:X}, 0x{:02X}", (instruction & 0xF00) >> 8,
+                     instruction & 0xFF);
+}
+
+std::string Debugger::disassembleArithmetic(
+    const Instruction& instruction) const {
+  const char* mnemonic = this->arithmetic_mnemonics[instruction & 0xF];
+  if (mnemonic == nullptr) return this->disassembleNoop(instruction);
+
+  return std::format("{} V{:X}, V{:X}", mnemonic, (instruction & 0xF00) >> 8,
+                     (instruction & 0xF0) >> 4);
+}
+
+std::string Debugger::disassembleSetIndex(
+    const Instruction& instruction) const {
+  return std::format("LD I, 0x{:03X}", instruction & 0xFFF);
+}
+
+std::string Debugger::disassembleJumpWithOffset(
+    const Instruction& instruction) const {
+#ifdef ORIGINAL_CHIP8
+  return std::format("JP V0, 0x{:03X}", instruction & 0xFFF);
+#else
+  return std::format("JP V{:X}, 0x{:03X}", (instruction & 0xF00) >> 8,
+                     instruction & 0xFFF);
+#endif
+}
+
+std::string Debugger::disassembleRandom(const Instruction& instruction) const {
+  return std::format("RND V{:X}, 0x{:02X}", (instruction & 0xF00) >> 8,
+                     instruction & 0xFF);
+}
+
+std::string Debugger::disassembleDraw(const Instruction& instruction) const {
+  return std::format("DRW V{:X}, V{:X}, {}", (instruction & 0xF00) >> 8,
+                     (instruction & 0xF0) >> 4, instruction & 0xF);
+}
+
+std::string Debugger::disassembleSkipIfKey(
+    const Instruction& instruction) const {
+  uint16_t register_x = (instruction & 0xF00) >> 8;
+
+  switch (instruction & 0xFF) {
+    case 0x9E:
+      return std::format("SKP V{:X}", register_x);
+    case 0xA1:
+      return std::format("SKNP V{:X}", register_x);
+  }
+
+  return this->disassembleNoop(instruction);
+}
+
+std::string Debugger::disassembleF(const Instruction& instruction) const {
+  uint16_t register_x = (instruction & 0xF00) >> 8;
+
+  switch (instruction & 0xFF) {
+    case 0x07:
+      return std::format("LD V{:X}, DT", register_x);
+    case 0x0A:
+      return std::format("LD V{:X}, K", register_x);
+    case 0x15:
+      return std::format("LD DT, V{:X}", register_x);
+    case 0x18:
+      return std::format("LD ST, V{:X}", register_x);
+    case 0x1E:
+      return std::format("ADD I, V{:X}", register_x);
+    case 0x29:
+      return std::format("LD F, V{:X}", register_x);
+    case 0x33:
+      return std::format("LD B, V{:X}", register_x);
+    case 0x55:
+      return std::format("LD [I], V{:X}", register_x);
+    case 0x65:
+      return std::format("LD V{:X}, [I]", register_x);
+  }
+
+  return this->disassembleNoop(instruction);
+}
@@ -0,0 +1,105 @@
+#ifndef GUARD_DEBUGGER_H
+#define GUARD_DEBUGGER_H
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Memory.h"
+#include "Processor.h"
+
+class Debugger {
+ public:
+  typedef Processor::Address Address;
+  typedef Processor::Instruction Instruction;
+  typedef Processor::RegisterValue RegisterValue;
+
+  enum class Comparison {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL
+  };
+
+  Debugger(Processor& processor);
+
+  void addBreakpoint(const Address address);
+  void addConditionalBreakpoint(const Address address,
+                                const uint16_t register_to_check,
+                                const Comparison comparison,
+                                const RegisterValue value);
+  void removeBreakpoint(const Address address);
+  void addWatchpoint(const Address address);
+  void removeWatchpoint(const Address address);
+
+  void pause();
+  bool shouldBreak();
+  bool prompt();
+  void onMemoryWrite(const Address address);
+  void onTrap();
+
+  std::string disassemble(const Instruction& instruction) const;
+
+ private:
+  enum class StepMode { NONE, STEP, STEP_OVER, STEP_OUT };
+
+  struct Condition {
+    uint16_t register_to_check;
+    Comparison comparison;
+    RegisterValue value;
+  };
+
+  Processor& processor;
+  std::bitset<Memory::SIZE> breakpoints;
+  std::bitset<Memory::SIZE> watchpoints;
+  std::bitset<Memory::PAGE_COUNT> watched_pages;
+  std::unordered_map<Address, std::vector<Condition>> conditions;
+  StepMode step_mode;
+  Address step_target;
+  std::size_t step_depth;
+  bool is_trap_pending;
+  // Watched addresses written since the last check, as Fx55 and Fx33 can
+  // hit several in one instruction
+  std::vector<Address> watch_hits;
+
+  bool isConditionMet(const Condition& condition) const;
+  bool startStepOver();
+  bool startStepOut();
+  bool resume();
+
+  Instruction readInstruction(const Address address) const;
+  void printRegisters() const;
+  void printMemory(const Address address, const std::size_t count) const;
+  void printDisassembly(const Address address, const std::size_t count) const;
+
+  void initializeDisassemblers();
+
+  // Disassembly by first nibble, mirrors Processor::INSTRUCTION_TABLE
+  std::string disassembleNoop(const Instruction& instruction) const;
+  std::string disassemble0(const Instruction& instruction) const;
+  std::string disassembleJump(const Instruction& instruction) const;
+  std::string disassembleCall(const Instruction& instruction) const;
+  std::string disassembleConstantSkip(const Instruction& instruction) const;
+  std::string disassembleRegisterSkip(const Instruction& instruction) const;
+  std::string disassembleSetRegister(const Instruction& instruction) const;
+  std::string disassembleAddToRegister(const Instruction& instruction) const;
+  std::string disassembleArithmetic(const Instruction& instruction) const;
+  std::string disassembleSetIndex(const Instruction& instruction) const;
+  std::string disassembleJumpWithOffset(const Instruction& instruction) const;
+  std::string disassembleRandom(const Instruction& instruction) const;
+  std::string disassembleDraw(const Instruction& instruction) const;
+  std::string disassembleSkipIfKey(const Instruction& instruction) const;
+  std::string disassembleF(const Instruction& instruction) const;
+
+  typedef std::string (Debugger::*Disassembler)(
+      const Instruction& instruction) const;
+
+  Disassembler disassembly_table[0x10];
+  const char* arithmetic_mnemonics[0x10];
+};
+
+#endif
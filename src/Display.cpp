@@ -2,39 +2,47 @@
 
 #include <SDL.h>
 
+#include <string>
+
 const uint8_t VIDEO_WIDTH = 64;
 const uint8_t VIDEO_HEIGHT = 32;
 
 const uint32_t WHITE = 0xFFFFFFFF;
 const uint32_t BLACK = 0x0;
 
-Display::Display() { this->initDisplay(1); }
+Display::Display() : is_headless{false} { this->initDisplay(1); }
+
+Display::Display(unsigned int scale_factor) : is_headless{false} {
+  this->initDisplay(scale_factor);
+}
 
-Display::Display(unsigned int scale_factor) { this->initDisplay(scale_factor); }
+Display::Display(unsigned int scale_factor, bool is_headless)
+    : is_headless{is_headless} {
+  this->initDisplay(scale_factor);
+}
+
+void Display::upload() {
+  if (this->is_headless) return;
 
-void Display::update() {
   SDL_UpdateTexture(this->texture.get(), nullptr, this->surface->pixels,
                     this->surface->pitch);
+}
+
+void Display::present() {
+  if (this->is_headless) return;
+
   SDL_RenderClear(this->renderer.get());
   SDL_RenderCopy(this->renderer.get(), this->texture.get(), nullptr, nullptr);
   SDL_RenderPresent(this->renderer.get());
 }
 
-void Display::initDisplay(unsigned int scale_factor) {
-  SDL_Init(SDL_INIT_VIDEO);
-
-  unsigned int scaled_width = VIDEO_WIDTH * scale_factor;
-  unsigned int scaled_height = VIDEO_HEIGHT * scale_factor;
-
-  SDL_Window* raw_window =
-      SDL_CreateWindow("Chip8 Emulator", 100, 100, scaled_width, scaled_height,
-                       SDL_WindowFlags::SDL_WINDOW_SHOWN);
-  this->window.reset(raw_window, &SDL_DestroyWindow);
+void Display::setTitle(const std::string& title) {
+  if (this->is_headless) return;
 
-  SDL_Renderer* raw_renderer = SDL_CreateRenderer(
-      this->window.get(), -1, SDL_RendererFlags::SDL_RENDERER_ACCELERATED);
-  this->renderer.reset(raw_renderer, &SDL_DestroyRenderer);
+  SDL_SetWindowTitle(this->window.get(), title.c_str());
+}
 
+void Display::initDisplay(unsigned int scale_factor) {
   uint32_t rmask, gmask, bmask, amask;
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
@@ -52,12 +60,28 @@ void Display::initDisplay(unsigned int scale_factor) {
   SDL_Surface* raw_surface = SDL_CreateRGBSurface(
       0, VIDEO_WIDTH, VIDEO_HEIGHT, 32, rmask, gmask, bmask, amask);
   this->surface.reset(raw_surface, &SDL_FreeSurface);
+  this->size = VIDEO_WIDTH * VIDEO_HEIGHT;
+
+  // Headless displays only keep the framebuffer, without a window to show it
+  if (this->is_headless) return;
+
+  SDL_Init(SDL_INIT_VIDEO);
+
+  unsigned int scaled_width = VIDEO_WIDTH * scale_factor;
+  unsigned int scaled_height = VIDEO_HEIGHT * scale_factor;
+
+  SDL_Window* raw_window =
+      SDL_CreateWindow("Chip8 Emulator", 100, 100, scaled_width, scaled_height,
+                       SDL_WindowFlags::SDL_WINDOW_SHOWN);
+  this->window.reset(raw_window, &SDL_DestroyWindow);
+
+  SDL_Renderer* raw_renderer = SDL_CreateRenderer(
+      this->window.get(), -1, SDL_RendererFlags::SDL_RENDERER_ACCELERATED);
+  this->renderer.reset(raw_renderer, &SDL_DestroyRenderer);
 
   SDL_Texture* raw_texture =
       SDL_CreateTextureFromSurface(this->renderer.get(), this->surface.get());
   this->texture.reset(raw_texture, &SDL_DestroyTexture);
-
-  this->size = VIDEO_WIDTH * VIDEO_HEIGHT;
 }
 
 void Display::clear() { SDL_FillRect(this->surface.get(), nullptr, BLACK); }
@@ -75,3 +99,26 @@ bool Display::flipPixel(size_t index) {
   ((uint32_t*)this->surface->pixels)[index] = WHITE;
   return false;
 }
+
+const uint32_t* Display::getPixels() const {
+  return (const uint32_t*)this->surface->pixels;
+}
+
+Display::Framebuffer Display::saveFramebuffer() const {
+  const uint32_t* pixels = this->getPixels();
+  Framebuffer framebuffer;
+
+  for (size_t i = 0; i < this->size; i++) {
+    if (pixels[i] == WHITE) framebuffer.set(i);
+  }
+
+  return framebuffer;
+}
+
+void Display::loadFramebuffer(const Framebuffer& framebuffer) {
+  uint32_t* pixels = (uint32_t*)this->surface->pixels;
+
+  for (size_t i = 0; i < this->size; i++) {
+    pixels[i] = framebuffer.test(i) ? WHITE : BLACK;
+  }
+}
@@ -3,17 +3,27 @@
 
 #include <SDL.h>
 
+#include <bitset>
 #include <memory>
+#include <string>
 
 class Display {
  public:
+  typedef std::bitset<64 * 32> Framebuffer;
+
   Display();
   Display(unsigned int scale_factor);
+  Display(unsigned int scale_factor, bool is_headless);
 
-  void update();
+  void upload();
+  void present();
+  void setTitle(const std::string& title);
   void clear();
   size_t getSize();
   bool flipPixel(size_t index);
+  const uint32_t* getPixels() const;
+  Framebuffer saveFramebuffer() const;
+  void loadFramebuffer(const Framebuffer& framebuffer);
 
  private:
   std::shared_ptr<SDL_Window> window;
@@ -21,6 +31,7 @@ class Display {
   std::shared_ptr<SDL_Surface> surface;
   std::shared_ptr<SDL_Texture> texture;
   size_t size;
+  bool is_headless;
 
   void initDisplay(unsigned int scale_factor);
 };
@@ -1,31 +1,146 @@
 #include "Emulator.h"
 
 #include <cstdint>
+#include <format>
+#include <iostream>
 #include <string>
 
 static const uint16_t MILLISEC_IN_SEC = 1000;
+static const uint32_t INSTRUCTIONS_PER_EVENT_POLL = 1024;
 
 Emulator::Emulator(const std::string& rom_path)
+    : Emulator{rom_path, Options{}} {}
+
+Emulator::Emulator(const std::string& rom_path, const Options& options)
     : frames_per_second{60},
       keypad{},
       display{15},
-      processor{rom_path, this->display, this->keypad} {}
+      processor{rom_path, this->display, this->keypad},
+      is_showing_overlay{options.is_showing_overlay} {
+  this->processor.setFaultPolicy(options.fault_policy);
+
+  if (!options.telemetry_path.empty() || options.is_showing_overlay ||
+      options.is_counting_perf) {
+    this->telemetry = std::make_unique<Telemetry>(options.telemetry_path,
+                                                  options.is_counting_perf);
+  }
+
+#ifdef CHIP8_DEBUGGER
+  if (options.is_debugging) {
+    this->debugger = std::make_unique<Debugger>(this->processor);
+    this->debugger->pause();
+    this->processor.attachDebugger(this->debugger.get());
+  }
+#endif
+
+#ifdef CHIP8_SHARED_STATE
+  if (!options.shared_state_name.empty()) {
+    this->shared_state_exporter =
+        std::make_unique<SharedStateExporter>(options.shared_state_name);
+  }
+#endif
+}
 
 void Emulator::start() {
   const uint32_t millisec_for_frame = MILLISEC_IN_SEC / this->frames_per_second;
 
+  // Telemetry reads the clock only at phase boundaries, since a clock read
+  // costs about as much as emulating an instruction
+  Telemetry::TimePoint phase_start;
+
   bool is_done = false;
   while (!is_done) {
+    if (this->telemetry) phase_start = this->telemetry->now();
+
     is_done = this->keypad.processEvents();
-    this->processor.process();
 
-    if (!this->processor.shouldUpdateDisplay()) {
+#ifdef CHIP8_SHARED_STATE
+    if (this->shared_state_exporter) {
+      this->shared_state_exporter->applyInput(this->keypad);
+    }
+#endif
+
+    if (this->telemetry) {
+      phase_start = this->telemetry->record(Telemetry::Phase::EVENTS,
+                                            phase_start);
+    }
+
+    // Emulate until the display needs updating, polling events again after
+    // a bounded batch so input still arrives while nothing is drawn
+    bool should_update_display = false;
+    uint32_t batch_instructions = 0;
+    while (!should_update_display &&
+           batch_instructions < INSTRUCTIONS_PER_EVENT_POLL) {
+#ifdef CHIP8_DEBUGGER
+      if (this->debugger && this->debugger->shouldBreak()) {
+        if (this->debugger->prompt()) {
+          is_done = true;
+          break;
+        }
+        this->is_halt_reported = false;
+
+        // Time spent at the prompt should not count towards emulation
+        if (this->telemetry) phase_start = this->telemetry->now();
+      }
+#endif
+
+      this->processor.process();
+      batch_instructions++;
+
+      if (this->processor.isHalted()) break;
+      should_update_display = this->processor.shouldUpdateDisplay();
+    }
+
+    if (this->telemetry) {
+      phase_start = this->telemetry->record(Telemetry::Phase::PROCESS,
+                                            phase_start);
+      this->telemetry->countInstructions(batch_instructions);
+    }
+
+    if (is_done) break;
+
+    if (!should_update_display) {
+#ifdef CHIP8_SHARED_STATE
+      if (this->shared_state_exporter) {
+        this->publishIdleFrame(millisec_for_frame);
+      }
+#endif
+
+      // A halted machine only waits for the window to close, or for the
+      // debugger to resume it
+      if (this->processor.isHalted()) {
+        this->reportHalt();
+        SDL_Delay(millisec_for_frame);
+      }
       continue;
     }
 
     int start_time = SDL_GetTicks();
 
-    this->display.update();
+    if (this->telemetry) phase_start = this->telemetry->now();
+
+    this->display.upload();
+
+    if (this->telemetry) {
+      phase_start = this->telemetry->record(Telemetry::Phase::UPLOAD,
+                                            phase_start);
+    }
+
+    this->display.present();
+
+    if (this->telemetry) {
+      this->telemetry->record(Telemetry::Phase::PRESENT, phase_start);
+
+      bool has_new_summary = this->telemetry->endFrame();
+      if (has_new_summary && this->is_showing_overlay) {
+        this->display.setTitle("Chip8 Emulator | " +
+                               this->telemetry->getSummary());
+      }
+    }
+
+#ifdef CHIP8_SHARED_STATE
+    if (this->shared_state_exporter) this->publishSharedState();
+#endif
 
     int time_taken = SDL_GetTicks() - start_time;
 
@@ -36,3 +151,39 @@ void Emulator::start() {
     if (sleep_time > 0) SDL_Delay(sleep_time);
   }
 }
+
+void Emulator::reportHalt() {
+  if (this->is_halt_reported) return;
+  this->is_halt_reported = true;
+
+  std::string message =
+      std::format("Halted on {} at 0x{:03X}",
+                  Processor::getTrapName(this->processor.getTrap()),
+                  this->processor.getTrapAddress());
+  std::cerr << message << "\n";
+  this->display.setTitle("Chip8 Emulator | " + message);
+}
+
+#ifdef CHIP8_SHARED_STATE
+void Emulator::publishSharedState() {
+  this->shared_state_exporter->publish(this->processor, this->display);
+  this->published_trap = this->processor.getTrap();
+  this->published_ticks = SDL_GetTicks();
+}
+
+void Emulator::publishIdleFrame(const uint32_t millisec_for_frame) {
+  bool has_new_trap = this->processor.getTrap() != this->published_trap;
+
+  // Halted or blocked on Fx0A, the machine draws nothing until input
+  // arrives, so keep publishing at the frame rate for whoever provides it.
+  // Elapsed ticks decide when, since sleeping here would slow the guest.
+  if (!has_new_trap) {
+    if (!this->processor.isHalted() && !this->processor.isWaitingForKey()) {
+      return;
+    }
+    if (SDL_GetTicks() - this->published_ticks < millisec_for_frame) return;
+  }
+
+  this->publishSharedState();
+}
+#endif
@@ -2,15 +2,35 @@
 #define GUARD_EMULATOR_H
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include "Display.h"
 #include "Keypad.h"
 #include "Processor.h"
+#include "Telemetry.h"
+
+#ifdef CHIP8_DEBUGGER
+#include "Debugger.h"
+#endif
+
+#ifdef CHIP8_SHARED_STATE
+#include "SharedState.h"
+#endif
 
 class Emulator {
  public:
+  struct Options {
+    bool is_debugging = false;
+    Processor::FaultPolicy fault_policy = Processor::FaultPolicy::HALT;
+    std::string shared_state_name;
+    std::string telemetry_path;
+    bool is_showing_overlay = false;
+    bool is_counting_perf = false;
+  };
+
   Emulator(const std::string& rom_path);
+  Emulator(const std::string& rom_path, const Options& options);
   void start();
 
  private:
@@ -18,6 +38,24 @@ class Emulator {
   Display display;
   Processor processor;
   uint32_t frames_per_second;
+  std::unique_ptr<Telemetry> telemetry;
+  bool is_showing_overlay;
+  bool is_halt_reported = false;
+
+  void reportHalt();
+
+#ifdef CHIP8_DEBUGGER
+  std::unique_ptr<Debugger> debugger;
+#endif
+
+#ifdef CHIP8_SHARED_STATE
+  std::unique_ptr<SharedStateExporter> shared_state_exporter;
+  Processor::Trap published_trap = Processor::Trap::NONE;
+  uint32_t published_ticks = 0;
+
+  void publishSharedState();
+  void publishIdleFrame(const uint32_t millisec_for_frame);
+#endif
 };
 
 #endif
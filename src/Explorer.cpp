@@ -0,0 +1,173 @@
+#include "Explorer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Display.h"
+#include "Keypad.h"
+#include "Processor.h"
+
+Explorer::Explorer(const std::string& rom_path, const Options& options)
+    : rom_path{rom_path}, options{options} {
+  if (this->options.beam_width == 0 || this->options.keys.empty()) {
+    throw std::invalid_argument(
+        "Explorer needs a beam width of at least 1 and at least one key");
+  }
+
+  if (this->options.thread_count == 0) {
+    this->options.thread_count =
+        std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+Explorer::Result Explorer::explore(const Processor::Snapshot& start,
+                                   const Scorer& scorer) {
+  Result result{{}, 0, 0, 0};
+
+  for (SeenShard& shard : this->seen_shards) shard.hashes.clear();
+  this->markSeen(start.getHash());
+
+  {
+    Keypad keypad;
+    Display display{1, true};
+    Processor processor{this->rom_path, display, keypad};
+    processor.loadSnapshot(start);
+    result.score = scorer(processor);
+  }
+
+  std::vector<Node> frontier;
+  frontier.push_back({start, result.score, 0, Explorer::NO_KEY});
+
+  // Parent index and key of every node kept at each depth, to rebuild the
+  // input sequence without holding on to old snapshots
+  std::vector<std::vector<std::pair<std::size_t, int>>> history;
+
+  const std::vector<int>& keys = this->options.keys;
+  std::atomic<uint64_t> pruned_count{0};
+
+  // Shared with the workers, and only changed while they wait at a barrier
+  std::vector<std::optional<Node>> branches;
+  std::size_t branch_count = 0;
+  std::atomic<std::size_t> next_branch{0};
+  bool is_done = false;
+
+  // Workers and this thread meet at depth_start before every depth, and at
+  // depth_end once all of its branches have run
+  std::ptrdiff_t party_count = this->options.thread_count + 1;
+  std::barrier depth_start{party_count};
+  std::barrier depth_end{party_count};
+
+  // Every worker builds its machine once, since loading a snapshot replaces
+  // all of its state
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < this->options.thread_count; i++) {
+    workers.emplace_back([&]() {
+      Keypad keypad;
+      Display display{1, true};
+      Processor processor{this->rom_path, display, keypad};
+
+      while (true) {
+        depth_start.arrive_and_wait();
+        if (is_done) return;
+
+        for (std::size_t index = next_branch++; index < branch_count;
+             index = next_branch++) {
+          std::size_t parent = index / keys.size();
+          int key = keys[index % keys.size()];
+
+          processor.loadSnapshot(frontier[parent].snapshot);
+          keypad.releaseAllKeys();
+          if (key != Explorer::NO_KEY) keypad.setKeyPressed(key, true);
+
+          for (uint32_t instruction = 0;
+               instruction < this->options.instructions_per_decision;
+               instruction++) {
+            processor.process();
+          }
+
+          Processor::Snapshot snapshot = processor.saveSnapshot();
+          if (!this->markSeen(snapshot.getHash())) {
+            pruned_count++;
+            continue;
+          }
+
+          branches[index].emplace(
+              Node{std::move(snapshot), scorer(processor), parent, key});
+        }
+
+        depth_end.arrive_and_wait();
+      }
+    });
+  }
+
+  for (std::size_t depth = 0; depth < this->options.depth; depth++) {
+    branch_count = frontier.size() * keys.size();
+    branches.assign(branch_count, std::nullopt);
+    next_branch = 0;
+
+    depth_start.arrive_and_wait();
+    depth_end.arrive_and_wait();
+    result.branch_count += branch_count;
+
+    std::vector<Node> next_frontier;
+    for (std::optional<Node>& branch : branches) {
+      if (branch) next_frontier.push_back(std::move(*branch));
+    }
+
+    // Every branch reached a state that was already explored
+    if (next_frontier.empty()) break;
+
+    std::stable_sort(next_frontier.begin(), next_frontier.end(),
+                     [](const Node& first, const Node& second) {
+                       return first.score > second.score;
+                     });
+    if (next_frontier.size() > this->options.beam_width) {
+      next_frontier.erase(next_frontier.begin() + this->options.beam_width,
+                          next_frontier.end());
+    }
+
+    std::vector<std::pair<std::size_t, int>>& layer = history.emplace_back();
+    for (const Node& node : next_frontier) {
+      layer.emplace_back(node.parent, node.key);
+    }
+
+    frontier = std::move(next_frontier);
+  }
+
+  is_done = true;
+  depth_start.arrive_and_wait();
+  for (std::thread& worker : workers) worker.join();
+
+  // The frontier is sorted, so the best node of the last depth is first. It
+  // always holds at least the start, since every depth keeps a branch or
+  // ends the search.
+  result.score = frontier.front().score;
+  result.inputs.resize(history.size());
+
+  std::size_t index = 0;
+  for (std::size_t depth = history.size(); depth > 0; depth--) {
+    const auto& [parent, key] = history[depth - 1][index];
+    result.inputs[depth - 1] = key;
+    index = parent;
+  }
+
+  result.pruned_count = pruned_count;
+  return result;
+}
+
+bool Explorer::markSeen(const uint64_t hash) {
+  SeenShard& shard = this->seen_shards[hash % Explorer::SEEN_SHARD_COUNT];
+  std::lock_guard<std::mutex> lock{shard.mutex};
+
+  return shard.hashes.insert(hash).second;
+}
@@ -0,0 +1,66 @@
+#ifndef GUARD_EXPLORER_H
+#define GUARD_EXPLORER_H
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Processor.h"
+
+// Searches for input sequences by branching a machine into every key state
+// at each decision frame and keeping the best scoring branches (a beam
+// search). Branches run headless in parallel, and states already reached
+// by another branch are pruned by their snapshot hash.
+class Explorer {
+ public:
+  typedef std::function<double(const Processor& processor)> Scorer;
+
+  // A key of NO_KEY means no key is held for that decision
+  static const int NO_KEY = -1;
+
+  struct Options {
+    std::vector<int> keys = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7,
+                             0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF};
+    std::size_t depth = 60;
+    std::size_t beam_width = 64;
+    uint32_t instructions_per_decision = 12;
+    unsigned int thread_count = 0;
+  };
+
+  struct Result {
+    std::vector<int> inputs;
+    double score;
+    uint64_t branch_count;
+    uint64_t pruned_count;
+  };
+
+  Explorer(const std::string& rom_path, const Options& options);
+
+  Result explore(const Processor::Snapshot& start, const Scorer& scorer);
+
+ private:
+  static const std::size_t SEEN_SHARD_COUNT = 64;
+
+  struct Node {
+    Processor::Snapshot snapshot;
+    double score;
+    std::size_t parent;
+    int key;
+  };
+
+  struct SeenShard {
+    std::mutex mutex;
+    std::unordered_set<uint64_t> hashes;
+  };
+
+  std::string rom_path;
+  Options options;
+  SeenShard seen_shards[SEEN_SHARD_COUNT];
+
+  bool markSeen(const uint64_t hash);
+};
+
+#endif
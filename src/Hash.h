@@ -0,0 +1,20 @@
+#ifndef GUARD_HASH_H
+#define GUARD_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a, used for state hashes that must stay stable across runs
+const uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325;
+const uint64_t FNV_PRIME = 0x100000001B3;
+
+inline uint64_t hashBytes(uint64_t hash, const void* bytes, std::size_t size) {
+  const uint8_t* data = (const uint8_t*)bytes;
+  for (std::size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * FNV_PRIME;
+  }
+
+  return hash;
+}
+
+#endif
@@ -52,6 +52,16 @@ bool Keypad::processEvents() {
   return false;
 }
 
+void Keypad::setKeyPressed(const uint8_t key, const bool is_pressed) {
+  if (is_pressed) {
+    this->pressed_keys.insert(key);
+  } else {
+    this->pressed_keys.erase(key);
+  }
+}
+
+void Keypad::releaseAllKeys() { this->pressed_keys.clear(); }
+
 bool Keypad::isKeyPressed(const uint8_t key_to_be_checked) const {
   return this->pressed_keys.find(key_to_be_checked) !=
          this->pressed_keys.cend();
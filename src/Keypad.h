@@ -11,6 +11,8 @@ class Keypad {
   Keypad();
 
   bool processEvents();
+  void setKeyPressed(const uint8_t key, const bool is_pressed);
+  void releaseAllKeys();
   bool isKeyPressed(const uint8_t key_to_be_checked) const;
   int getKey() const;
 
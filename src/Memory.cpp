@@ -0,0 +1,83 @@
+#include "Memory.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Hash.h"
+
+Memory::Memory(const std::string& rom, const Value* font,
+               const std::size_t font_size, const Address font_address,
+               const Address rom_address) {
+  std::string contents(Memory::SIZE, '\0');
+  std::copy_n(font, std::min(font_size, Memory::SIZE - font_address),
+              contents.begin() + font_address);
+  std::copy_n(rom.begin(), std::min(rom.size(), Memory::SIZE - rom_address),
+              contents.begin() + rom_address);
+
+  this->image = Memory::loadImage(contents);
+  this->pages = *this->image;
+}
+
+std::shared_ptr<const Memory::Pages> Memory::loadImage(
+    const std::string& contents) {
+  static const std::shared_ptr<Page> ZERO_PAGE = std::make_shared<Page>();
+  static std::mutex images_mutex;
+  static std::unordered_map<std::string, std::weak_ptr<const Pages>> images;
+
+  std::lock_guard<std::mutex> lock{images_mutex};
+
+  auto iter = images.find(contents);
+  if (iter != images.end()) {
+    std::shared_ptr<const Pages> image = iter->second.lock();
+    if (image) return image;
+  }
+
+  std::shared_ptr<Pages> image = std::make_shared<Pages>();
+  for (std::size_t i = 0; i < Memory::PAGE_COUNT; i++) {
+    auto page_begin = contents.begin() + i * Memory::PAGE_SIZE;
+    auto page_end = page_begin + Memory::PAGE_SIZE;
+
+    if (std::all_of(page_begin, page_end, [](char c) { return c == 0; })) {
+      (*image)[i] = ZERO_PAGE;
+      continue;
+    }
+
+    (*image)[i] = std::make_shared<Page>();
+    std::copy(page_begin, page_end, (*image)[i]->begin());
+  }
+
+  // Drop images no instance uses any more before caching the new one
+  std::erase_if(images,
+                [](const auto& entry) { return entry.second.expired(); });
+  images[contents] = image;
+
+  return image;
+}
+
+void Memory::write(const Address address, const Value value) {
+  std::shared_ptr<Page>& page = this->pages[address / Memory::PAGE_SIZE];
+
+  // The image, or another instance, still refers to this page
+  if (page.use_count() > 1) page = std::make_shared<Page>(*page);
+
+  (*page)[address % Memory::PAGE_SIZE] = value;
+}
+
+uint64_t Memory::getHash(uint64_t hash) const {
+  for (std::size_t i = 0; i < Memory::PAGE_COUNT; i++) {
+    // Pages still shared with the image are identified by their index alone,
+    // so only pages that have been written to need hashing
+    if (this->pages[i] == (*this->image)[i]) {
+      hash = hashBytes(hash, &i, sizeof(i));
+      continue;
+    }
+
+    hash = hashBytes(hash, this->pages[i]->data(), Memory::PAGE_SIZE);
+  }
+
+  return hash;
+}
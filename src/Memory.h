@@ -0,0 +1,44 @@
+#ifndef GUARD_MEMORY_H
+#define GUARD_MEMORY_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Copy-on-write memory. Pages start out shared with every other instance
+// loaded from the same font and ROM, and an instance only gets its own copy
+// of a page the first time it writes to it.
+class Memory {
+ public:
+  typedef uint16_t Address;
+  typedef uint8_t Value;
+
+  static const std::size_t SIZE = 4096;
+  static const std::size_t PAGE_SIZE = 256;
+  static const std::size_t PAGE_COUNT = SIZE / PAGE_SIZE;
+
+  Memory(const std::string& rom, const Value* font,
+         const std::size_t font_size, const Address font_address,
+         const Address rom_address);
+
+  Value read(const Address address) const;
+  void write(const Address address, const Value value);
+  uint64_t getHash(uint64_t hash) const;
+
+ private:
+  typedef std::array<Value, PAGE_SIZE> Page;
+  typedef std::array<std::shared_ptr<Page>, PAGE_COUNT> Pages;
+
+  static std::shared_ptr<const Pages> loadImage(const std::string& contents);
+
+  std::shared_ptr<const Pages> image;
+  Pages pages;
+};
+
+inline Memory::Value Memory::read(const Address address) const {
+  return (*this->pages[address / Memory::PAGE_SIZE])[address %
+                                                      Memory::PAGE_SIZE];
+}
+
+#endif
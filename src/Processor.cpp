@@ -2,14 +2,19 @@
 
 #include <algorithm>
 #include <chrono>
-#include <format>
 #include <fstream>
+#include <iterator>
 #include <random>
-#include <stdexcept>
 #include <string>
 
 #include "Display.h"
+#include "Hash.h"
 #include "Keypad.h"
+#include "Memory.h"
+
+#ifdef CHIP8_DEBUGGER
+#include "Debugger.h"
+#endif
 
 const uint8_t VIDEO_WIDTH = 64;
 const uint8_t VIDEO_HEIGHT = 32;
@@ -35,101 +40,164 @@ const Processor::Font Processor::FONT_SET[Processor::FONT_SET_SIZE] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80   // F
 };
 const Processor::Address Processor::FONT_SET_START_ADDRESS = 0x50;
+const Processor::Address Processor::PROGRAM_START_ADDRESS = 0x200;
+
+const Processor::InstructionProcessor Processor::INSTRUCTION_TABLE[0x10] = {
+    &Processor::processInstruction0,           // 0
+    &Processor::jump,                          // 1
+    &Processor::call,                          // 2
+    &Processor::constantComparisonSkip,        // 3
+    &Processor::constantComparisonSkip,        // 4
+    &Processor::registerComparisonSkip,        // 5
+    &Processor::setRegister,                   // 6
+    &Processor::addToRegister,                 // 7
+    &Processor::processArithmeticInstruction,  // 8
+    &Processor::registerComparisonSkip,        // 9
+    &Processor::setIndexRegister,              // A
+    &Processor::jumpWithOffset,                // B
+    &Processor::genRandomNumber,               // C
+    &Processor::draw,                          // D
+    &Processor::skipIfKey,                     // E
+    &Processor::processInstructionF            // F
+};
+
+const Processor::ArithmeticInstructionProcessor
+    Processor::ARITHMETIC_INSTRUCTION_TABLE[0x10] = {
+        &Processor::set,                // 0
+        &Processor::logicalOr,          // 1
+        &Processor::logicalAnd,         // 2
+        &Processor::logicalXor,         // 3
+        &Processor::add,                // 4
+        &Processor::subtractYFromX,     // 5
+        &Processor::shiftRight,         // 6
+        &Processor::subtractXFromY,     // 7
+        &Processor::invalidArithmetic,  // 8
+        &Processor::invalidArithmetic,  // 9
+        &Processor::invalidArithmetic,  // A
+        &Processor::invalidArithmetic,  // B
+        &Processor::invalidArithmetic,  // C
+        &Processor::invalidArithmetic,  // D
+        &Processor::shiftLeft,          // E
+        &Processor::invalidArithmetic   // F
+};
+
+static std::string readRom(const std::string& rom_path) {
+  std::ifstream rom{rom_path, std::ios::binary};
+  if (!rom.is_open()) return "";
+
+  return std::string{std::istreambuf_iterator<char>{rom},
+                     std::istreambuf_iterator<char>{}};
+}
 
 Processor::Processor(const std::string& rom_path, Display& display,
                      const Keypad& keypad)
-    : program_counter{0x200},
+    : stack_pointer{0},
+      program_counter{PROGRAM_START_ADDRESS},
       index_register{0x0},
       delay_timer{0x0},
       sound_timer{0x0},
-      memory{},
+      memory{readRom(rom_path), FONT_SET, FONT_SET_SIZE, FONT_SET_START_ADDRESS,
+             PROGRAM_START_ADDRESS},
       display{display},
       keypad{keypad},
-      random_engine{
-          std::chrono::system_clock::now().time_since_epoch().count()},
-      should_update_display{false} {
-  this->initializeInstructionProcessors();
-  this->uniform_int_distribution =
-      std::uniform_int_distribution<short>{0, 255u};
+      random_engine{static_cast<std::minstd_rand::result_type>(
+          std::chrono::system_clock::now().time_since_epoch().count())},
+      should_update_display{false},
+      fault_policy{FaultPolicy::HALT},
+      trap{Trap::NONE},
+      trap_address{0x0},
+      is_halted{false} {
   std::fill_n(this->registers, 16, 0x0);
-  memcpy(memory + FONT_SET_START_ADDRESS, FONT_SET, FONT_SET_SIZE);
-
-  std::ifstream rom{rom_path, std::ios::binary | std::ios::ate};
-  if (rom.is_open()) {
-    std::streampos size = rom.tellg();
-    char* buffer = (char*)malloc(size * sizeof(char));
+  std::fill_n(this->stack, Processor::STACK_SIZE, 0x0);
+}
 
-    // Go back to beginning of the file and fill the buffer
-    rom.seekg(0, std::ios::beg);
-    rom.read(buffer, size);
-    rom.close();
+void Processor::process() {
+  if (this->is_halted) return;
 
-    memcpy(memory + program_counter, buffer, size);
-    free(buffer);
+  // There is no instruction to skip past, so a fetch fault halts under every
+  // policy rather than trapping again on every call
+  if (this->program_counter > Memory::SIZE - 2) {
+    this->raiseTrap(Trap::MEMORY_OUT_OF_BOUNDS, this->program_counter);
+    this->is_halted = true;
+    return;
   }
-}
-
-void Processor::initializeInstructionProcessors() {
-  std::fill_n(this->instruction_table, 0x10, &Processor::noop);
-
-  this->instruction_table[0x0] = &Processor::processInstruction0;
-  this->instruction_table[0x1] = &Processor::jump;
-  this->instruction_table[0x2] = &Processor::call;
-  this->instruction_table[0x3] = &Processor::constantComparisonSkip;
-  this->instruction_table[0x4] = &Processor::constantComparisonSkip;
-  this->instruction_table[0x5] = &Processor::registerComparisonSkip;
-  this->instruction_table[0x6] = &Processor::setRegister;
-  this->instruction_table[0x7] = &Processor::addToRegister;
-  this->instruction_table[0x8] = &Processor::processArithmeticInstruction;
-  this->instruction_table[0x9] = &Processor::registerComparisonSkip;
-  this->instruction_table[0xA] = &Processor::setIndexRegister;
-  this->instruction_table[0xB] = &Processor::jumpWithOffset;
-  this->instruction_table[0xC] = &Processor::genRandomNumber;
-  this->instruction_table[0xD] = &Processor::draw;
-  this->instruction_table[0xE] = &Processor::skipIfKey;
-  this->instruction_table[0xF] = &Processor::processInstructionF;
-
-  std::fill_n(this->arithmetic_instruction_table, 0x10,
-              &Processor::noopArithmetic);
-
-  this->arithmetic_instruction_table[0x0] = &Processor::set;
-  this->arithmetic_instruction_table[0x1] = &Processor::logicalOr;
-  this->arithmetic_instruction_table[0x2] = &Processor::logicalAnd;
-  this->arithmetic_instruction_table[0x3] = &Processor::logicalXor;
-  this->arithmetic_instruction_table[0x4] = &Processor::add;
-  this->arithmetic_instruction_table[0x5] = &Processor::subtractYFromX;
-  this->arithmetic_instruction_table[0x6] = &Processor::shiftRight;
-  this->arithmetic_instruction_table[0x7] = &Processor::subtractXFromY;
-  this->arithmetic_instruction_table[0xE] = &Processor::shiftLeft;
-}
 
-void Processor::process() {
   Instruction instruction = this->getInstruction();
   uint16_t first_nibble = instruction >> 12;
   this->should_update_display = false;
 
-  (this->*instruction_table[first_nibble])(instruction);
+  (this->*INSTRUCTION_TABLE[first_nibble])(instruction);
 
   if (this->delay_timer > 0) this->delay_timer--;
   if (this->sound_timer > 0) this->sound_timer--;
 }
 
 Processor::Instruction Processor::getInstruction() {
-  MemoryValue first_half = this->memory[this->program_counter++];
-  MemoryValue second_half = this->memory[this->program_counter++];
+  MemoryValue first_half = this->memory.read(this->program_counter++);
+  MemoryValue second_half = this->memory.read(this->program_counter++);
   Instruction instruction = (first_half << 8) | second_half;
 
   return instruction;
 }
 
-void Processor::noop(const Instruction& instruction) {}
+void Processor::writeMemory(const Address address, const MemoryValue value) {
+  this->memory.write(address, value);
+
+#ifdef CHIP8_DEBUGGER
+  if (this->debugger != nullptr) this->debugger->onMemoryWrite(address);
+#endif
+}
+
+bool Processor::checkMemoryAccess(const std::size_t address,
+                                  const std::size_t count) {
+  if (address + count <= Memory::SIZE) return true;
+
+  this->raiseTrap(Trap::MEMORY_OUT_OF_BOUNDS);
+  return false;
+}
+
+void Processor::raiseTrap(const Trap trap) {
+  // The program counter has already moved past the faulting instruction
+  this->raiseTrap(trap, this->program_counter - 2);
+}
+
+void Processor::raiseTrap(const Trap trap, const Address address) {
+  this->trap = trap;
+  this->trap_address = address;
+
+  switch (this->fault_policy) {
+    case FaultPolicy::IGNORE:
+      return;
+
+    case FaultPolicy::BREAK:
+#ifdef CHIP8_DEBUGGER
+      if (this->debugger != nullptr) {
+        this->debugger->onTrap();
+        return;
+      }
+#endif
+      // Without a debugger to break into, fall back to halting
+      [[fallthrough]];
+
+    case FaultPolicy::HALT:
+      this->program_counter = address;
+      this->is_halted = true;
+#ifdef CHIP8_DEBUGGER
+      // The debugger can still show the trap and resume past it
+      if (this->debugger != nullptr) this->debugger->onTrap();
+#endif
+      return;
+  }
+}
 
 void Processor::processInstruction0(const Instruction& instruction) {
   uint16_t second_nibble = (instruction & 0xF00) >> 8;
   uint16_t third_nibble = (instruction & 0xF0) >> 4;
   uint16_t fourth_nibble = (instruction & 0xF);
 
+  // 0NNN machine code routines are not supported
   if (second_nibble != 0x0 || third_nibble != 0xE) {
+    this->raiseTrap(Trap::INVALID_INSTRUCTION);
     return;
   }
 
@@ -140,13 +208,16 @@ void Processor::processInstruction0(const Instruction& instruction) {
       break;
 
     case 0xE:
-      if (this->stack.empty()) {
-        throw std::logic_error(
-            "Stack should not be empty when 0x00EE is called");
+      if (this->stack_pointer == 0) {
+        this->raiseTrap(Trap::STACK_UNDERFLOW);
+        break;
       }
 
-      this->program_counter = this->stack.top();
-      this->stack.pop();
+      this->program_counter = this->stack[--this->stack_pointer];
+      break;
+
+    default:
+      this->raiseTrap(Trap::INVALID_INSTRUCTION);
       break;
   }
 }
@@ -157,8 +228,13 @@ void Processor::jump(const Instruction& instruction) {
 }
 
 void Processor::call(const Instruction& instruction) {
+  if (this->stack_pointer == Processor::STACK_SIZE) {
+    this->raiseTrap(Trap::STACK_OVERFLOW);
+    return;
+  }
+
   Address new_address = (instruction & 0xFFF);
-  this->stack.push(this->program_counter);
+  this->stack[this->stack_pointer++] = this->program_counter;
   this->program_counter = new_address;
 }
 
@@ -181,16 +257,15 @@ void Processor::constantComparisonSkip(const Instruction& instruction) {
       break;
 
     default:
-      throw std::logic_error(std::format(
-          "First nibble of compare constant skip instruction should not be {}",
-          instruction_type));
+      this->raiseTrap(Trap::INVALID_INSTRUCTION);
+      break;
   }
 }
 
 void Processor::registerComparisonSkip(const Instruction& instruction) {
   if ((instruction & 0xF) != 0) {
-    throw std::logic_error(
-        "Compare register skip instruction should have last nibble as 0x0");
+    this->raiseTrap(Trap::INVALID_INSTRUCTION);
+    return;
   }
 
   uint16_t register_x = (instruction & 0xF00) >> 8;
@@ -211,9 +286,8 @@ void Processor::registerComparisonSkip(const Instruction& instruction) {
       break;
 
     default:
-      throw std::logic_error(std::format(
-          "First nibble of compare register skip instruction should not be {}",
-          instruction_type));
+      this->raiseTrap(Trap::INVALID_INSTRUCTION);
+      break;
   }
 }
 
@@ -234,8 +308,8 @@ void Processor::processArithmeticInstruction(const Instruction& instruction) {
   uint16_t register_y = (instruction & 0xF0) >> 4;
   uint16_t instruction_type = instruction & 0xF;
 
-  (this->*arithmetic_instruction_table[instruction_type])(register_x,
-                                                          register_y);
+  (this->*ARITHMETIC_INSTRUCTION_TABLE[instruction_type])(register_x,
+                                                           register_y);
 }
 
 void Processor::setIndexRegister(const Instruction& instruction) {
@@ -258,8 +332,9 @@ void Processor::jumpWithOffset(const Instruction& instruction) {
 void Processor::genRandomNumber(const Instruction& instruction) {
   uint16_t register_to_set = (instruction & 0xF00) >> 8;
   uint16_t value = instruction & 0xFF;
-  this->registers[register_to_set] =
-      this->uniform_int_distribution(this->random_engine) & value;
+  // Masked straight from the engine, since distributions are implementation
+  // defined and seeded runs should match on every standard library
+  this->registers[register_to_set] = this->random_engine() & value;
 }
 
 void Processor::draw(const Instruction& instruction) {
@@ -269,10 +344,12 @@ void Processor::draw(const Instruction& instruction) {
   RegisterValue x_pos = this->registers[x_register] % VIDEO_WIDTH;
   RegisterValue y_pos = this->registers[y_register] % VIDEO_HEIGHT;
 
+  if (!this->checkMemoryAccess(this->index_register, height)) return;
+
   this->registers[Processor::FLAG_REGISTER] = 0;
 
   for (uint16_t row = 0; row < height; row++) {
-    MemoryValue sprite_byte = this->memory[this->index_register + row];
+    MemoryValue sprite_byte = this->memory.read(this->index_register + row);
 
     for (uint16_t col = 0; col < BYTE_SIZE; col++) {
       MemoryValue sprite_pixel = sprite_byte & (0x80 >> col);
@@ -298,11 +375,10 @@ void Processor::skipIfKey(const Instruction& instruction) {
   uint16_t register_to_be_checked = (instruction & 0xF00) >> 8;
   RegisterValue key_to_be_checked = this->registers[register_to_be_checked];
 
-  bool is_valid_key = key_to_be_checked >= 0x0 && key_to_be_checked <= 0xF;
+  bool is_valid_key = key_to_be_checked <= 0xF;
   if (!is_valid_key) {
-    throw std::logic_error(
-        std::format("Skip if key instruction encountered invalid key: {}",
-                    key_to_be_checked));
+    this->raiseTrap(Trap::INVALID_KEY);
+    return;
   }
 
   bool is_key_pressed = this->keypad.isKeyPressed(key_to_be_checked);
@@ -322,9 +398,8 @@ void Processor::skipIfKey(const Instruction& instruction) {
       break;
 
     default:
-      throw std::logic_error(
-          std::format("Skip if key instruction should not have last byte as {}",
-                      instruction_type));
+      this->raiseTrap(Trap::INVALID_INSTRUCTION);
+      break;
   }
 }
 
@@ -376,34 +451,46 @@ void Processor::processInstructionF(const Instruction& instruction) {
 
     // Binary-coded decimal conversion
     case 0x33:
+      if (!this->checkMemoryAccess(this->index_register, 3)) break;
+
       for (int i = 2; i >= 0; i--) {
-        this->memory[this->index_register + i] = value % 10;
+        this->writeMemory(this->index_register + i, value % 10);
         value /= 10;
       }
       break;
 
     // Store memory
     case 0x55:
+      if (!this->checkMemoryAccess(this->index_register, register_x + 1)) {
+        break;
+      }
+
       for (int i = 0; i <= register_x; i++) {
-        this->memory[this->index_register + i] = this->registers[i];
+        this->writeMemory(this->index_register + i, this->registers[i]);
       }
       break;
 
     // Load memory
     case 0x65:
+      if (!this->checkMemoryAccess(this->index_register, register_x + 1)) {
+        break;
+      }
+
       for (int i = 0; i <= register_x; i++) {
-        this->registers[i] = this->memory[this->index_register + i];
+        this->registers[i] = this->memory.read(this->index_register + i);
       }
       break;
 
     default:
-      throw std::logic_error(std::format(
-          "Instruction F should not have last byte {}", instruction_type));
+      this->raiseTrap(Trap::INVALID_INSTRUCTION);
+      break;
   }
 }
 
-void Processor::noopArithmetic(const uint16_t register_x,
-                               const uint16_t register_y) {}
+void Processor::invalidArithmetic(const uint16_t register_x,
+                                  const uint16_t register_y) {
+  this->raiseTrap(Trap::INVALID_INSTRUCTION);
+}
 
 void Processor::set(const uint16_t register_x, const uint16_t register_y) {
   this->registers[register_x] = this->registers[register_y];
@@ -473,3 +560,140 @@ void Processor::shiftLeft(const uint16_t register_x,
 }
 
 bool Processor::shouldUpdateDisplay() { return this->should_update_display; }
+
+bool Processor::isWaitingForKey() const {
+  if (this->program_counter > Memory::SIZE - 2) return false;
+
+  Instruction instruction = (this->memory.read(this->program_counter) << 8) |
+                            this->memory.read(this->program_counter + 1);
+  return (instruction & 0xF0FF) == 0xF00A && this->keypad.getKey() == -1;
+}
+
+void Processor::seedRandom(unsigned int seed) {
+  this->random_engine.seed(seed);
+}
+
+Processor::Address Processor::getProgramCounter() const {
+  return this->program_counter;
+}
+
+Processor::IndexRegisterValue Processor::getIndexRegister() const {
+  return this->index_register;
+}
+
+const Processor::RegisterValue* Processor::getRegisters() const {
+  return this->registers;
+}
+
+Processor::Timer Processor::getDelayTimer() const { return this->delay_timer; }
+
+Processor::Timer Processor::getSoundTimer() const { return this->sound_timer; }
+
+Processor::MemoryValue Processor::readMemory(const Address address) const {
+  // Only the low 12 bits address memory, as in Debugger::parseAddress
+  return this->memory.read(address & 0xFFF);
+}
+
+Processor::Snapshot Processor::saveSnapshot() const {
+  Snapshot snapshot{.stack_pointer = this->stack_pointer,
+                    .program_counter = this->program_counter,
+                    .memory = this->memory,
+                    .index_register = this->index_register,
+                    .delay_timer = this->delay_timer,
+                    .sound_timer = this->sound_timer,
+                    .random_engine = this->random_engine,
+                    .trap = this->trap,
+                    .trap_address = this->trap_address,
+                    .is_halted = this->is_halted,
+                    .framebuffer = this->display.saveFramebuffer()};
+  std::copy_n(this->stack, Processor::STACK_SIZE, snapshot.stack);
+  std::copy_n(this->registers, 16, snapshot.registers);
+
+  return snapshot;
+}
+
+void Processor::loadSnapshot(const Snapshot& snapshot) {
+  std::copy_n(snapshot.stack, Processor::STACK_SIZE, this->stack);
+  this->stack_pointer = snapshot.stack_pointer;
+  this->program_counter = snapshot.program_counter;
+  this->memory = snapshot.memory;
+  std::copy_n(snapshot.registers, 16, this->registers);
+  this->index_register = snapshot.index_register;
+  this->delay_timer = snapshot.delay_timer;
+  this->sound_timer = snapshot.sound_timer;
+  this->random_engine = snapshot.random_engine;
+  this->trap = snapshot.trap;
+  this->trap_address = snapshot.trap_address;
+  this->is_halted = snapshot.is_halted;
+  this->display.loadFramebuffer(snapshot.framebuffer);
+}
+
+uint64_t Processor::Snapshot::getHash() const {
+  // The random engine is left out, so branches that only differ in how
+  // often they drew random numbers still count as the same state
+  uint64_t hash = FNV_OFFSET_BASIS;
+  // Slots above the stack pointer hold stale return addresses
+  hash = hashBytes(hash, this->stack, this->stack_pointer * sizeof(Address));
+  hash = hashBytes(hash, &this->stack_pointer, sizeof(this->stack_pointer));
+  hash = hashBytes(hash, &this->program_counter,
+                   sizeof(this->program_counter));
+  hash = hashBytes(hash, this->registers, sizeof(this->registers));
+  hash = hashBytes(hash, &this->index_register, sizeof(this->index_register));
+  hash = hashBytes(hash, &this->delay_timer, sizeof(this->delay_timer));
+  hash = hashBytes(hash, &this->sound_timer, sizeof(this->sound_timer));
+  hash = hashBytes(hash, &this->is_halted, sizeof(this->is_halted));
+  hash = this->memory.getHash(hash);
+
+  // std::hash of a bitset is not fixed by the standard, so the pixels are
+  // packed into bytes to keep the hash stable across runs
+  uint8_t framebuffer_bytes[Display::Framebuffer{}.size() / BYTE_SIZE] = {};
+  for (std::size_t i = 0; i < this->framebuffer.size(); i++) {
+    if (this->framebuffer.test(i)) {
+      framebuffer_bytes[i / BYTE_SIZE] |= 1 << (i % BYTE_SIZE);
+    }
+  }
+
+  return hashBytes(hash, framebuffer_bytes, sizeof(framebuffer_bytes));
+}
+
+void Processor::setFaultPolicy(const FaultPolicy fault_policy) {
+  this->fault_policy = fault_policy;
+}
+
+Processor::Trap Processor::getTrap() const { return this->trap; }
+
+Processor::Address Processor::getTrapAddress() const {
+  return this->trap_address;
+}
+
+bool Processor::isHalted() const { return this->is_halted; }
+
+void Processor::clearTrap() {
+  this->trap = Trap::NONE;
+  this->is_halted = false;
+}
+
+const char* Processor::getTrapName(const Trap trap) {
+  switch (trap) {
+    case Trap::NONE:
+      return "none";
+    case Trap::INVALID_INSTRUCTION:
+      return "invalid instruction";
+    case Trap::INVALID_KEY:
+      return "invalid key";
+    case Trap::STACK_UNDERFLOW:
+      return "stack underflow";
+    case Trap::STACK_OVERFLOW:
+      return "stack overflow";
+    case Trap::MEMORY_OUT_OF_BOUNDS:
+      return "memory out of bounds";
+  }
+
+  return "unknown";
+}
+
+#ifdef CHIP8_DEBUGGER
+void Processor::attachDebugger(Debugger* debugger) {
+  this->debugger = debugger;
+}
+#endif
@@ -3,54 +3,126 @@
 
 #include <cstdint>
 #include <random>
-#include <stack>
 #include <string>
 
 #include "Display.h"
 #include "Keypad.h"
+#include "Memory.h"
+
+class Debugger;
 
 class Processor {
+  friend class Debugger;
+
  public:
   typedef uint16_t Address;
   typedef uint8_t Font;
   typedef uint16_t IndexRegisterValue;
   typedef uint16_t Instruction;
-  typedef uint8_t MemoryValue;
+  typedef Memory::Value MemoryValue;
   typedef uint8_t RegisterValue;
-  typedef std::stack<Address> Stack;
+  typedef uint8_t StackPointer;
   typedef uint8_t Timer;
 
+  static const std::size_t STACK_SIZE = 16;
+
+  // Faults are recorded here instead of being thrown, so a bad ROM only
+  // stops its own machine
+  enum class Trap {
+    NONE,
+    INVALID_INSTRUCTION,
+    INVALID_KEY,
+    STACK_UNDERFLOW,
+    STACK_OVERFLOW,
+    MEMORY_OUT_OF_BOUNDS
+  };
+
+  enum class FaultPolicy { HALT, IGNORE, BREAK };
+
+  // Everything needed to resume a machine, including its framebuffer.
+  // Copies are cheap since memory pages are shared copy-on-write.
+  struct Snapshot {
+    Address stack[STACK_SIZE];
+    StackPointer stack_pointer;
+    Address program_counter;
+    Memory memory;
+    RegisterValue registers[16];
+    IndexRegisterValue index_register;
+    Timer delay_timer;
+    Timer sound_timer;
+    std::minstd_rand random_engine;
+    Trap trap;
+    Address trap_address;
+    bool is_halted;
+    Display::Framebuffer framebuffer;
+
+    uint64_t getHash() const;
+  };
+
   Processor(const std::string& rom_path, Display& display,
             const Keypad& keypad);
 
   void process();
   bool shouldUpdateDisplay();
+  bool isWaitingForKey() const;
+  void seedRandom(unsigned int seed);
+
+  Address getProgramCounter() const;
+  IndexRegisterValue getIndexRegister() const;
+  const RegisterValue* getRegisters() const;
+  Timer getDelayTimer() const;
+  Timer getSoundTimer() const;
+  MemoryValue readMemory(const Address address) const;
+
+  Snapshot saveSnapshot() const;
+  void loadSnapshot(const Snapshot& snapshot);
+
+  void setFaultPolicy(const FaultPolicy fault_policy);
+  Trap getTrap() const;
+  Address getTrapAddress() const;
+  bool isHalted() const;
+  void clearTrap();
+  static const char* getTrapName(const Trap trap);
+
+#ifdef CHIP8_DEBUGGER
+  void attachDebugger(Debugger* debugger);
+#endif
 
  private:
   static const std::size_t FONT_SET_SIZE;
   static const Font FONT_SET[];
   static const Address FONT_SET_START_ADDRESS;
+  static const Address PROGRAM_START_ADDRESS;
   static const uint16_t FLAG_REGISTER = 0xF;
 
-  Stack stack;
+  Address stack[STACK_SIZE];
+  StackPointer stack_pointer;
   Address program_counter;
-  MemoryValue memory[4096];
+  Memory memory;
   RegisterValue registers[16];
   IndexRegisterValue index_register;
   Timer delay_timer;
   Timer sound_timer;
   Display& display;
   const Keypad& keypad;
-  std::default_random_engine random_engine;
-  std::uniform_int_distribution<short> uniform_int_distribution;
+  std::minstd_rand random_engine;
   bool should_update_display;
+  FaultPolicy fault_policy;
+  Trap trap;
+  Address trap_address;
+  bool is_halted;
 
-  Instruction getInstruction();
+#ifdef CHIP8_DEBUGGER
+  Debugger* debugger = nullptr;
+#endif
 
-  void initializeInstructionProcessors();
+  Instruction getInstruction();
+  void writeMemory(const Address address, const MemoryValue value);
+  bool checkMemoryAccess(const std::size_t address, const std::size_t count);
+  void raiseTrap(const Trap trap);
+  void raiseTrap(const Trap trap, const Address address);
 
   // Regular instructions
-  void noop(const Instruction& instruction);
   void processInstruction0(const Instruction& instruction);
   void jump(const Instruction& instruction);
   void call(const Instruction& instruction);
@@ -67,7 +139,8 @@ class Processor {
   void processInstructionF(const Instruction& instruction);
 
   // Arithmetic instructions
-  void noopArithmetic(const uint16_t register_x, const uint16_t register_y);
+  void invalidArithmetic(const uint16_t register_x,
+                         const uint16_t register_y);
   void set(const uint16_t register_x, const uint16_t register_y);
   void logicalOr(const uint16_t register_x, const uint16_t register_y);
   void logicalAnd(const uint16_t register_x, const uint16_t register_y);
@@ -83,8 +156,9 @@ class Processor {
   typedef void (Processor::*ArithmeticInstructionProcessor)(
       const uint16_t register_x, const uint16_t register_y);
 
-  InstructionProcessor instruction_table[0x10];
-  ArithmeticInstructionProcessor arithmetic_instruction_table[0x10];
+  static const InstructionProcessor INSTRUCTION_TABLE[0x10];
+  static const ArithmeticInstructionProcessor
+      ARITHMETIC_INSTRUCTION_TABLE[0x10];
 };
 
 #endif
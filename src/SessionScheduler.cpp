@@ -0,0 +1,346 @@
+#include "SessionScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Display.h"
+#include "Keypad.h"
+#include "Processor.h"
+
+const SessionScheduler::Clock::duration SessionScheduler::TICK_DURATION =
+    std::chrono::milliseconds{1};
+const SessionScheduler::Clock::duration SessionScheduler::FRAME_DURATION =
+    std::chrono::microseconds{1000000 / 60};
+
+Session::Task Session::Task::promise_type::get_return_object() {
+  return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+}
+
+std::suspend_always Session::Task::promise_type::initial_suspend() noexcept {
+  return {};
+}
+
+Session::Task::FinalAwaiter
+Session::Task::promise_type::final_suspend() noexcept {
+  return {};
+}
+
+void Session::Task::promise_type::return_void() {}
+
+void Session::Task::promise_type::unhandled_exception() { std::terminate(); }
+
+bool Session::Task::FinalAwaiter::await_ready() const noexcept {
+  return false;
+}
+
+void Session::Task::FinalAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> handle) noexcept {
+  // The frame is destroyed in here, so nothing may touch it afterwards
+  handle.promise().scheduler->finishSession(handle.promise().session_id);
+}
+
+void Session::Task::FinalAwaiter::await_resume() const noexcept {}
+
+Session::Session(const Id id, const std::string& rom_path)
+    : id{id},
+      keypad{},
+      display{1, true},
+      processor{rom_path, this->display, this->keypad},
+      task{},
+      is_closed{false},
+      frame_count{0},
+      missed_frame_count{0} {}
+
+Session::Id Session::getId() const { return this->id; }
+
+const Processor& Session::getProcessor() const { return this->processor; }
+
+const Display& Session::getDisplay() const { return this->display; }
+
+uint64_t Session::getFrameCount() const { return this->frame_count; }
+
+uint64_t Session::getMissedFrameCount() const {
+  return this->missed_frame_count;
+}
+
+bool Session::applyInput() {
+  std::lock_guard<std::mutex> lock{this->input_mutex};
+
+  for (const auto& [key, is_pressed] : this->pending_input) {
+    this->keypad.setKeyPressed(key, is_pressed);
+  }
+  this->pending_input.clear();
+
+  return !this->is_closed;
+}
+
+SessionScheduler::SessionScheduler(const unsigned int thread_count,
+                                   const uint32_t instructions_per_frame)
+    : instructions_per_frame{instructions_per_frame},
+      next_session_id{0},
+      finished_frame_count{0},
+      finished_missed_frame_count{0},
+      wheel_start_time{Clock::now()},
+      current_tick{0},
+      is_running{true} {
+  for (unsigned int i = 0; i < std::max(1u, thread_count); i++) {
+    this->workers.emplace_back(&SessionScheduler::runWorker, this);
+  }
+
+  this->timer_thread = std::thread{&SessionScheduler::runTimer, this};
+}
+
+SessionScheduler::~SessionScheduler() {
+  this->is_running = false;
+  this->ready_condition.notify_all();
+
+  for (std::thread& worker : this->workers) worker.join();
+  this->timer_thread.join();
+
+  // Every session is suspended now, so their frames can be destroyed
+  for (auto& [id, session] : this->sessions) session->task.handle.destroy();
+}
+
+Session::Id SessionScheduler::addSession(const std::string& rom_path) {
+  std::lock_guard<std::mutex> lock{this->sessions_mutex};
+
+  Session::Id id = this->next_session_id++;
+  auto iter =
+      this->sessions.emplace(id, std::make_unique<Session>(id, rom_path))
+          .first;
+
+  Session& session = *iter->second;
+  session.task = this->run(session);
+  session.task.handle.promise().scheduler = this;
+  session.task.handle.promise().session_id = id;
+  this->schedule(session.task.handle);
+
+  return id;
+}
+
+void SessionScheduler::postInput(const Session::Id id, const uint8_t key,
+                                 const bool is_pressed) {
+  std::coroutine_handle<> waiter;
+  {
+    // Held throughout, so the session cannot finish and be freed meanwhile
+    std::lock_guard<std::mutex> sessions_lock{this->sessions_mutex};
+    auto iter = this->sessions.find(id);
+    if (iter == this->sessions.end()) return;
+
+    Session& session = *iter->second;
+    std::lock_guard<std::mutex> input_lock{session.input_mutex};
+    session.pending_input.emplace_back(key, is_pressed);
+    std::swap(waiter, session.input_waiter);
+  }
+
+  if (waiter) this->schedule(waiter);
+}
+
+void SessionScheduler::closeSession(const Session::Id id) {
+  std::coroutine_handle<> waiter;
+  {
+    std::lock_guard<std::mutex> sessions_lock{this->sessions_mutex};
+    auto iter = this->sessions.find(id);
+    if (iter == this->sessions.end()) return;
+
+    Session& session = *iter->second;
+    std::lock_guard<std::mutex> input_lock{session.input_mutex};
+    session.is_closed = true;
+    std::swap(waiter, session.input_waiter);
+  }
+
+  if (waiter) this->schedule(waiter);
+}
+
+void SessionScheduler::setFrameCallback(const FrameCallback& frame_callback) {
+  this->frame_callback = frame_callback;
+}
+
+std::size_t SessionScheduler::getSessionCount() {
+  std::lock_guard<std::mutex> lock{this->sessions_mutex};
+  return this->sessions.size();
+}
+
+uint64_t SessionScheduler::getFrameCount() {
+  std::lock_guard<std::mutex> lock{this->sessions_mutex};
+
+  uint64_t frame_count = this->finished_frame_count;
+  for (const auto& [id, session] : this->sessions) {
+    frame_count += session->getFrameCount();
+  }
+
+  return frame_count;
+}
+
+uint64_t SessionScheduler::getMissedFrameCount() {
+  std::lock_guard<std::mutex> lock{this->sessions_mutex};
+
+  uint64_t missed_frame_count = this->finished_missed_frame_count;
+  for (const auto& [id, session] : this->sessions) {
+    missed_frame_count += session->getMissedFrameCount();
+  }
+
+  return missed_frame_count;
+}
+
+Session::Task SessionScheduler::run(Session& session) {
+  Clock::time_point deadline = Clock::now();
+
+  while (session.applyInput()) {
+    for (uint32_t i = 0; i < this->instructions_per_frame; i++) {
+      session.processor.process();
+    }
+
+    session.frame_count++;
+    if (this->frame_callback) this->frame_callback(session);
+
+    // Blocked on Fx0A or halted, so nothing changes until input arrives
+    if (session.processor.isWaitingForKey() || session.processor.isHalted()) {
+      co_await InputAwaiter{session};
+      deadline = Clock::now();
+      continue;
+    }
+
+    deadline += SessionScheduler::FRAME_DURATION;
+
+    // Skip the frames we could not keep up with rather than bursting
+    Clock::time_point now = Clock::now();
+    if (deadline < now) {
+      session.missed_frame_count++;
+      deadline = now;
+    }
+
+    co_await FrameAwaiter{*this, deadline};
+  }
+}
+
+void SessionScheduler::finishSession(const Session::Id id) {
+  std::unique_ptr<Session> session;
+  {
+    std::lock_guard<std::mutex> lock{this->sessions_mutex};
+    auto iter = this->sessions.find(id);
+    session = std::move(iter->second);
+    this->sessions.erase(iter);
+
+    this->finished_frame_count += session->getFrameCount();
+    this->finished_missed_frame_count += session->getMissedFrameCount();
+  }
+
+  session->task.handle.destroy();
+}
+
+bool SessionScheduler::FrameAwaiter::await_ready() const noexcept {
+  return false;
+}
+
+void SessionScheduler::FrameAwaiter::await_suspend(
+    std::coroutine_handle<> handle) {
+  this->scheduler.scheduleAt(this->deadline, handle);
+}
+
+void SessionScheduler::FrameAwaiter::await_resume() const noexcept {}
+
+bool SessionScheduler::InputAwaiter::await_ready() const noexcept {
+  return false;
+}
+
+bool SessionScheduler::InputAwaiter::await_suspend(
+    std::coroutine_handle<> handle) {
+  std::lock_guard<std::mutex> lock{this->session.input_mutex};
+
+  // Input that arrived while the batch ran means we should not suspend
+  if (!this->session.pending_input.empty() || this->session.is_closed) {
+    return false;
+  }
+
+  this->session.input_waiter = handle;
+  return true;
+}
+
+void SessionScheduler::InputAwaiter::await_resume() const noexcept {}
+
+void SessionScheduler::schedule(std::coroutine_handle<> handle) {
+  {
+    std::lock_guard<std::mutex> lock{this->ready_mutex};
+    this->ready_handles.push_back(handle);
+  }
+
+  this->ready_condition.notify_one();
+}
+
+void SessionScheduler::scheduleAt(const Clock::time_point deadline,
+                                  std::coroutine_handle<> handle) {
+  {
+    std::lock_guard<std::mutex> lock{this->wheel_mutex};
+
+    // Round up so a session never wakes before its deadline
+    uint64_t tick = (deadline - this->wheel_start_time +
+                     SessionScheduler::TICK_DURATION -
+                     Clock::duration{1}) /
+                    SessionScheduler::TICK_DURATION;
+
+    if (tick > this->current_tick) {
+      this->wheel[tick % SessionScheduler::WHEEL_SIZE].push_back(
+          {tick, handle});
+      return;
+    }
+  }
+
+  this->schedule(handle);
+}
+
+void SessionScheduler::runWorker() {
+  while (true) {
+    std::coroutine_handle<> handle;
+
+    {
+      std::unique_lock<std::mutex> lock{this->ready_mutex};
+      this->ready_condition.wait(lock, [this]() {
+        return !this->ready_handles.empty() || !this->is_running;
+      });
+
+      if (!this->is_running) return;
+
+      handle = this->ready_handles.front();
+      this->ready_handles.pop_front();
+    }
+
+    handle.resume();
+  }
+}
+
+void SessionScheduler::runTimer() {
+  std::vector<Timer> expired_timers;
+
+  while (this->is_running) {
+    Clock::time_point next_tick_time =
+        this->wheel_start_time +
+        (this->current_tick + 1) * SessionScheduler::TICK_DURATION;
+    std::this_thread::sleep_until(next_tick_time);
+
+    {
+      std::lock_guard<std::mutex> lock{this->wheel_mutex};
+      this->current_tick++;
+
+      // Timers more than one rotation away stay in the slot
+      std::vector<Timer>& slot =
+          this->wheel[this->current_tick % SessionScheduler::WHEEL_SIZE];
+      auto expired_begin =
+          std::partition(slot.begin(), slot.end(), [this](const Timer& timer) {
+            return timer.tick > this->current_tick;
+          });
+      expired_timers.assign(expired_begin, slot.end());
+      slot.erase(expired_begin, slot.end());
+    }
+
+    for (const Timer& timer : expired_timers) this->schedule(timer.handle);
+  }
+}
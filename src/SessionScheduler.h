@@ -0,0 +1,176 @@
+#ifndef GUARD_SESSION_SCHEDULER_H
+#define GUARD_SESSION_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Display.h"
+#include "Keypad.h"
+#include "Processor.h"
+
+class SessionScheduler;
+
+// A headless machine driven by the SessionScheduler. Input may be posted
+// from any thread, and is applied at the start of the next batch.
+class Session {
+ public:
+  typedef std::size_t Id;
+
+  Session(const Id id, const std::string& rom_path);
+
+  Id getId() const;
+  const Processor& getProcessor() const;
+  const Display& getDisplay() const;
+  uint64_t getFrameCount() const;
+  uint64_t getMissedFrameCount() const;
+
+ private:
+  friend class SessionScheduler;
+
+  // Coroutine that runs a session, suspended while it waits on a frame
+  // deadline or on input
+  struct Task {
+    struct promise_type;
+
+    // Hands a finished session back to its scheduler to be freed
+    struct FinalAwaiter {
+      bool await_ready() const noexcept;
+      void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+      void await_resume() const noexcept;
+    };
+
+    struct promise_type {
+      SessionScheduler* scheduler = nullptr;
+      Id session_id = 0;
+
+      Task get_return_object();
+      std::suspend_always initial_suspend() noexcept;
+      FinalAwaiter final_suspend() noexcept;
+      void return_void();
+      void unhandled_exception();
+    };
+
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  Id id;
+  Keypad keypad;
+  Display display;
+  Processor processor;
+  Task task;
+
+  std::mutex input_mutex;
+  std::vector<std::pair<uint8_t, bool>> pending_input;
+  std::coroutine_handle<> input_waiter;
+  bool is_closed;
+
+  std::atomic<uint64_t> frame_count;
+  std::atomic<uint64_t> missed_frame_count;
+
+  bool applyInput();
+};
+
+// Runs many sessions on a small thread pool. Each session emulates one
+// batch per 60 Hz frame and then suspends until its next frame deadline,
+// which is kept in a timer wheel. Sessions blocked on Fx0A suspend until
+// input arrives instead, so idle sessions cost nothing. A closed session is
+// freed as soon as its coroutine finishes.
+class SessionScheduler {
+ public:
+  typedef std::chrono::steady_clock Clock;
+  typedef std::function<void(const Session& session)> FrameCallback;
+
+  SessionScheduler(const unsigned int thread_count,
+                   const uint32_t instructions_per_frame);
+  ~SessionScheduler();
+
+  SessionScheduler(const SessionScheduler&) = delete;
+  SessionScheduler& operator=(const SessionScheduler&) = delete;
+
+  Session::Id addSession(const std::string& rom_path);
+  void postInput(const Session::Id id, const uint8_t key,
+                 const bool is_pressed);
+  void closeSession(const Session::Id id);
+  // Called on a worker thread after every batch. Set it before adding
+  // sessions.
+  void setFrameCallback(const FrameCallback& frame_callback);
+
+  std::size_t getSessionCount();
+  uint64_t getFrameCount();
+  uint64_t getMissedFrameCount();
+
+ private:
+  static const std::size_t WHEEL_SIZE = 256;
+  static const Clock::duration TICK_DURATION;
+  static const Clock::duration FRAME_DURATION;
+
+  struct Timer {
+    uint64_t tick;
+    std::coroutine_handle<> handle;
+  };
+
+  struct FrameAwaiter {
+    SessionScheduler& scheduler;
+    Clock::time_point deadline;
+
+    bool await_ready() const noexcept;
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept;
+  };
+
+  struct InputAwaiter {
+    Session& session;
+
+    bool await_ready() const noexcept;
+    bool await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept;
+  };
+
+  uint32_t instructions_per_frame;
+  FrameCallback frame_callback;
+
+  // Ids are never reused, so a stale id cannot reach a newer session
+  std::mutex sessions_mutex;
+  std::unordered_map<Session::Id, std::unique_ptr<Session>> sessions;
+  Session::Id next_session_id;
+  uint64_t finished_frame_count;
+  uint64_t finished_missed_frame_count;
+
+  std::mutex ready_mutex;
+  std::condition_variable ready_condition;
+  std::deque<std::coroutine_handle<>> ready_handles;
+
+  std::mutex wheel_mutex;
+  std::vector<Timer> wheel[WHEEL_SIZE];
+  Clock::time_point wheel_start_time;
+  uint64_t current_tick;
+
+  std::atomic<bool> is_running;
+  std::vector<std::thread> workers;
+  std::thread timer_thread;
+
+  friend struct Session::Task::FinalAwaiter;
+
+  Session::Task run(Session& session);
+  void finishSession(const Session::Id id);
+
+  void schedule(std::coroutine_handle<> handle);
+  void scheduleAt(const Clock::time_point deadline,
+                  std::coroutine_handle<> handle);
+  void runWorker();
+  void runTimer();
+};
+
+#endif
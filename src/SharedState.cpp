@@ -0,0 +1,88 @@
+#include "SharedState.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include "Display.h"
+#include "Keypad.h"
+#include "Processor.h"
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint16_t>::is_always_lock_free,
+              "Shared state atomics must be lock free to work across "
+              "processes");
+
+SharedStateExporter::SharedStateExporter(const std::string& name)
+    : name{name}, state{nullptr}, frame_counter{0}, applied_input_keys{0} {
+  int file_descriptor = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (file_descriptor == -1) {
+    throw std::runtime_error("Unable to open shared memory " + name);
+  }
+
+  if (ftruncate(file_descriptor, sizeof(SharedState)) == -1) {
+    close(file_descriptor);
+    throw std::runtime_error("Unable to size shared memory " + name);
+  }
+
+  void* region = mmap(nullptr, sizeof(SharedState), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, file_descriptor, 0);
+  close(file_descriptor);
+  if (region == MAP_FAILED) {
+    throw std::runtime_error("Unable to map shared memory " + name);
+  }
+
+  this->state = new (region) SharedState{};
+  this->state->magic = SharedState::MAGIC;
+  this->state->version = SharedState::VERSION;
+}
+
+SharedStateExporter::~SharedStateExporter() {
+  munmap(this->state, sizeof(SharedState));
+  shm_unlink(this->name.c_str());
+}
+
+void SharedStateExporter::publish(const Processor& processor,
+                                  const Display& display) {
+  uint32_t sequence = this->state->sequence.load(std::memory_order_relaxed);
+
+  // An odd sequence tells readers a write is in progress
+  this->state->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  this->state->frame_counter = ++this->frame_counter;
+  memcpy(this->state->pixels, display.getPixels(),
+         sizeof(this->state->pixels));
+  memcpy(this->state->registers, processor.getRegisters(),
+         sizeof(this->state->registers));
+  this->state->program_counter = processor.getProgramCounter();
+  this->state->index_register = processor.getIndexRegister();
+  this->state->delay_timer = processor.getDelayTimer();
+  this->state->sound_timer = processor.getSoundTimer();
+  this->state->trap = (uint8_t)processor.getTrap();
+  this->state->is_halted = processor.isHalted();
+
+  this->state->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void SharedStateExporter::applyInput(Keypad& keypad) {
+  uint16_t input_keys =
+      this->state->input_keys.load(std::memory_order_acquire);
+  uint16_t changed_keys = input_keys ^ this->applied_input_keys;
+  if (changed_keys == 0) return;
+
+  for (uint8_t key = 0; key < 16; key++) {
+    if (changed_keys & (1 << key)) {
+      keypad.setKeyPressed(key, input_keys & (1 << key));
+    }
+  }
+
+  this->applied_input_keys = input_keys;
+}
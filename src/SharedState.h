@@ -0,0 +1,57 @@
+#ifndef GUARD_SHARED_STATE_H
+#define GUARD_SHARED_STATE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "Display.h"
+#include "Keypad.h"
+#include "Processor.h"
+
+// Layout of the POSIX shared memory region. Consumers map it read-write,
+// since input is fed back by setting bits of input_keys (one bit per key)
+// with an atomic store. Every other field is written by the emulator only,
+// and is read using the sequence as a seqlock: read it, copy what they
+// need, then read it again, and retry if it was odd or changed. A frame is
+// published every display update, and every 60 Hz frame while the machine
+// is halted or waiting on Fx0A.
+struct SharedState {
+  static const uint32_t MAGIC = 0x43485038;  // "CHP8"
+  static const uint32_t VERSION = 1;
+  static const std::size_t PIXEL_COUNT = 64 * 32;
+
+  uint32_t magic;
+  uint32_t version;
+  std::atomic<uint32_t> sequence;
+  std::atomic<uint16_t> input_keys;
+  uint64_t frame_counter;
+  uint32_t pixels[PIXEL_COUNT];
+  uint8_t registers[16];
+  uint16_t program_counter;
+  uint16_t index_register;
+  uint8_t delay_timer;
+  uint8_t sound_timer;
+  uint8_t trap;
+  uint8_t is_halted;
+};
+
+class SharedStateExporter {
+ public:
+  SharedStateExporter(const std::string& name);
+  ~SharedStateExporter();
+
+  SharedStateExporter(const SharedStateExporter&) = delete;
+  SharedStateExporter& operator=(const SharedStateExporter&) = delete;
+
+  void publish(const Processor& processor, const Display& display);
+  void applyInput(Keypad& keypad);
+
+ private:
+  std::string name;
+  SharedState* state;
+  uint64_t frame_counter;
+  uint16_t applied_input_keys;
+};
+
+#endif
@@ -0,0 +1,237 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* PHASE_NAMES[] = {"events", "process", "upload", "present"};
+
+Telemetry::Telemetry(const std::string& dump_path, bool is_counting_perf)
+    : is_dumping_json{dump_path.ends_with(".json")},
+      current_frame{},
+      summary_frame{},
+      perf_group_fd{-1},
+      last_perf_values{} {
+  std::fill_n(this->perf_fds, Telemetry::PERF_COUNTER_COUNT, -1);
+
+  if (!dump_path.empty()) {
+    this->dump_file.open(dump_path, std::ios::out | std::ios::trunc);
+
+    if (!this->is_dumping_json) {
+      this->dump_file << "frame";
+      for (const char* phase_name : PHASE_NAMES) {
+        this->dump_file << "," << phase_name << "_ns";
+      }
+      this->dump_file << ",frame_ns,instructions_emulated,cpu_cycles,"
+                         "cpu_instructions,branch_misses\n";
+    }
+  }
+
+  if (is_counting_perf) this->openPerfCounters();
+
+  this->frame_start_time = this->now();
+}
+
+Telemetry::~Telemetry() {
+  this->dumpFrames();
+  this->closePerfCounters();
+}
+
+Telemetry::TimePoint Telemetry::now() const { return Clock::now(); }
+
+Telemetry::TimePoint Telemetry::record(const Phase phase,
+                                       const TimePoint start) {
+  TimePoint end = this->now();
+  this->current_frame.phase_nanoseconds[(std::size_t)phase] +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+          .count();
+  return end;
+}
+
+void Telemetry::countInstructions(const uint64_t count) {
+  this->current_frame.instructions_emulated += count;
+}
+
+bool Telemetry::endFrame() {
+  TimePoint end = this->now();
+  Frame& frame = this->current_frame;
+
+  frame.frame_nanoseconds =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          end - this->frame_start_time)
+          .count();
+  this->readPerfCounters(frame);
+
+  if (this->dump_file.is_open()) this->pending_frames.push_back(frame);
+
+  // Summaries are averaged over the same interval as the dumps
+  if (frame.frame % Telemetry::DUMP_INTERVAL_FRAMES == 0) {
+    this->summary_frame = {};
+  }
+
+  for (std::size_t i = 0; i < (std::size_t)Phase::COUNT; i++) {
+    this->summary_frame.phase_nanoseconds[i] += frame.phase_nanoseconds[i];
+  }
+  this->summary_frame.frame_nanoseconds += frame.frame_nanoseconds;
+  this->summary_frame.instructions_emulated += frame.instructions_emulated;
+  this->summary_frame.cpu_cycles += frame.cpu_cycles;
+  this->summary_frame.cpu_instructions += frame.cpu_instructions;
+  this->summary_frame.branch_misses += frame.branch_misses;
+  this->summary_frame.frame++;
+
+  uint64_t next_frame = frame.frame + 1;
+  this->current_frame = {};
+  this->current_frame.frame = next_frame;
+  this->frame_start_time = end;
+
+  if (next_frame % Telemetry::DUMP_INTERVAL_FRAMES != 0) return false;
+
+  this->dumpFrames();
+  return true;
+}
+
+std::string Telemetry::getSummary() const {
+  const Frame& summary = this->summary_frame;
+  if (summary.frame == 0) return "";
+
+  double frame_count = summary.frame;
+  double frame_milliseconds = summary.frame_nanoseconds / frame_count / 1e6;
+  std::string text = std::format(
+      "{:.1f} fps | {:.0f} ins/frame",
+      frame_milliseconds > 0 ? 1000 / frame_milliseconds : 0.0,
+      summary.instructions_emulated / frame_count);
+
+  for (std::size_t i = 0; i < (std::size_t)Phase::COUNT; i++) {
+    text += std::format(" | {} {:.2f} ms", PHASE_NAMES[i],
+                        summary.phase_nanoseconds[i] / frame_count / 1e6);
+  }
+
+  if (this->perf_group_fd != -1) {
+    text += std::format(
+        " | {:.2f} IPC | {:.0f} cycles/frame | {:.0f} branch misses/frame",
+        summary.cpu_cycles > 0
+            ? (double)summary.cpu_instructions / summary.cpu_cycles
+            : 0.0,
+        summary.cpu_cycles / frame_count, summary.branch_misses / frame_count);
+  }
+
+  return text;
+}
+
+void Telemetry::dumpFrames() {
+  if (!this->dump_file.is_open()) return;
+
+  for (const Frame& frame : this->pending_frames) {
+    if (this->is_dumping_json) {
+      this->dump_file << "{\"frame\":" << frame.frame;
+      for (std::size_t i = 0; i < (std::size_t)Phase::COUNT; i++) {
+        this->dump_file << ",\"" << PHASE_NAMES[i]
+                        << "_ns\":" << frame.phase_nanoseconds[i];
+      }
+      this->dump_file << ",\"frame_ns\":" << frame.frame_nanoseconds
+                      << ",\"instructions_emulated\":"
+                      << frame.instructions_emulated
+                      << ",\"cpu_cycles\":" << frame.cpu_cycles
+                      << ",\"cpu_instructions\":" << frame.cpu_instructions
+                      << ",\"branch_misses\":" << frame.branch_misses
+                      << "}\n";
+      continue;
+    }
+
+    this->dump_file << frame.frame;
+    for (std::size_t i = 0; i < (std::size_t)Phase::COUNT; i++) {
+      this->dump_file << "," << frame.phase_nanoseconds[i];
+    }
+    this->dump_file << "," << frame.frame_nanoseconds << ","
+                    << frame.instructions_emulated << "," << frame.cpu_cycles
+                    << "," << frame.cpu_instructions << ","
+                    << frame.branch_misses << "\n";
+  }
+
+  this->dump_file.flush();
+  this->pending_frames.clear();
+}
+
+#ifdef __linux__
+void Telemetry::openPerfCounters() {
+  const uint64_t configs[Telemetry::PERF_COUNTER_COUNT] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_BRANCH_MISSES};
+
+  for (std::size_t i = 0; i < Telemetry::PERF_COUNTER_COUNT; i++) {
+    perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = configs[i];
+    attributes.disabled = i == 0;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_GROUP;
+
+    // Count this thread on any CPU, grouped so all counters cover the
+    // same interval
+    this->perf_fds[i] = syscall(SYS_perf_event_open, &attributes, 0, -1,
+                                this->perf_group_fd, 0);
+    if (this->perf_fds[i] == -1) {
+      std::cerr << "perf_event_open failed, hardware counters are disabled\n";
+      this->closePerfCounters();
+      return;
+    }
+
+    if (i == 0) this->perf_group_fd = this->perf_fds[i];
+  }
+
+  ioctl(this->perf_group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(this->perf_group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void Telemetry::closePerfCounters() {
+  for (int& perf_fd : this->perf_fds) {
+    if (perf_fd != -1) close(perf_fd);
+    perf_fd = -1;
+  }
+
+  this->perf_group_fd = -1;
+}
+
+void Telemetry::readPerfCounters(Frame& frame) {
+  if (this->perf_group_fd == -1) return;
+
+  struct {
+    uint64_t count;
+    uint64_t values[Telemetry::PERF_COUNTER_COUNT];
+  } group;
+
+  if (read(this->perf_group_fd, &group, sizeof(group)) != sizeof(group)) {
+    return;
+  }
+
+  uint64_t* deltas[Telemetry::PERF_COUNTER_COUNT] = {
+      &frame.cpu_cycles, &frame.cpu_instructions, &frame.branch_misses};
+  for (std::size_t i = 0; i < Telemetry::PERF_COUNTER_COUNT; i++) {
+    *deltas[i] = group.values[i] - this->last_perf_values[i];
+    this->last_perf_values[i] = group.values[i];
+  }
+}
+#else
+void Telemetry::openPerfCounters() {
+  std::cerr << "Hardware counters are only supported on Linux\n";
+}
+
+void Telemetry::closePerfCounters() {}
+
+void Telemetry::readPerfCounters(Frame& frame) {}
+#endif
@@ -0,0 +1,63 @@
+#ifndef GUARD_TELEMETRY_H
+#define GUARD_TELEMETRY_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Wall time per frame split into host phases, optionally alongside hardware
+// counters from perf_event_open (Linux only). Events are polled and
+// instructions emulated in batches, each timed as a whole.
+class Telemetry {
+ public:
+  typedef std::chrono::steady_clock Clock;
+  typedef Clock::time_point TimePoint;
+
+  enum class Phase { EVENTS, PROCESS, UPLOAD, PRESENT, COUNT };
+
+  struct Frame {
+    uint64_t frame;
+    uint64_t phase_nanoseconds[(std::size_t)Phase::COUNT];
+    uint64_t frame_nanoseconds;
+    uint64_t instructions_emulated;
+    uint64_t cpu_cycles;
+    uint64_t cpu_instructions;
+    uint64_t branch_misses;
+  };
+
+  Telemetry(const std::string& dump_path, bool is_counting_perf);
+  ~Telemetry();
+
+  Telemetry(const Telemetry&) = delete;
+  Telemetry& operator=(const Telemetry&) = delete;
+
+  TimePoint now() const;
+  TimePoint record(const Phase phase, const TimePoint start);
+  void countInstructions(const uint64_t count);
+  bool endFrame();
+  std::string getSummary() const;
+
+ private:
+  static const std::size_t DUMP_INTERVAL_FRAMES = 60;
+  static const std::size_t PERF_COUNTER_COUNT = 3;
+
+  std::ofstream dump_file;
+  bool is_dumping_json;
+  std::vector<Frame> pending_frames;
+  Frame current_frame;
+  Frame summary_frame;
+  TimePoint frame_start_time;
+
+  int perf_group_fd;
+  int perf_fds[PERF_COUNTER_COUNT];
+  uint64_t last_perf_values[PERF_COUNTER_COUNT];
+
+  void openPerfCounters();
+  void closePerfCounters();
+  void readPerfCounters(Frame& frame);
+  void dumpFrames();
+};
+
+#endif
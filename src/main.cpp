@@ -1,15 +1,180 @@
 ﻿#define SDL_MAIN_HANDLED
 
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <iostream>
 #include <string>
+#include <thread>
 
+#include "Display.h"
 #include "Emulator.h"
+#include "Explorer.h"
+#include "Keypad.h"
+#include "Memory.h"
+#include "Processor.h"
+#include "SessionScheduler.h"
+
+static const uint32_t SESSION_INSTRUCTIONS_PER_FRAME = 12;
+static const unsigned int EXPLORER_SEED = 0;
+
+// Runs headless copies of the ROM on the session scheduler until stdin is
+// closed or a line is entered
+static int runSessions(const std::string& rom_path,
+                       const std::size_t session_count) {
+  SessionScheduler scheduler{std::thread::hardware_concurrency(),
+                             SESSION_INSTRUCTIONS_PER_FRAME};
+  for (std::size_t i = 0; i < session_count; i++) {
+    scheduler.addSession(rom_path);
+  }
+
+  auto start_time = std::chrono::steady_clock::now();
+  std::string line;
+  std::getline(std::cin, line);
+  auto time_taken = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start_time);
+
+  std::cout << std::format(
+      "{} sessions, {} frames, {} missed deadlines in {} ms\n",
+      scheduler.getSessionCount(), scheduler.getFrameCount(),
+      scheduler.getMissedFrameCount(), time_taken.count());
+  return 0;
+}
+
+// Searches for the inputs that maximise a register (Vx) or a memory address
+// (hex) after the given number of decisions
+static int runExplorer(const std::string& rom_path,
+                       const Explorer::Options& explorer_options,
+                       const std::string& score_target) {
+  Explorer::Scorer scorer;
+  if (score_target.size() == 2 &&
+      (score_target[0] == 'V' || score_target[0] == 'v')) {
+    std::size_t register_index =
+        std::stoul(score_target.substr(1), nullptr, 16);
+    scorer = [register_index](const Processor& processor) {
+      return processor.getRegisters()[register_index];
+    };
+  } else {
+    unsigned long address = std::stoul(score_target, nullptr, 16);
+    if (address >= Memory::SIZE) {
+      std::cerr << "Score address is out of range\n";
+      return -1;
+    }
+
+    scorer = [address](const Processor& processor) {
+      return processor.readMemory(address);
+    };
+  }
+
+  Keypad keypad;
+  Display display{1, true};
+  Processor processor{rom_path, display, keypad};
+  // Fixed so the inputs found replay the same way
+  processor.seedRandom(EXPLORER_SEED);
+
+  auto start_time = std::chrono::steady_clock::now();
+  Explorer explorer{rom_path, explorer_options};
+  Explorer::Result result = explorer.explore(processor.saveSnapshot(), scorer);
+  auto time_taken = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start_time);
+
+  for (int key : result.inputs) {
+    std::cout << (key == Explorer::NO_KEY ? "-" : std::format("{:X}", key));
+  }
+  std::cout << std::format(
+      "\nscore {}, {} branches, {} pruned in {} ms\n", result.score,
+      result.branch_count, result.pruned_count, time_taken.count());
+  return 0;
+}
 
 int main(int argc, char* argv[]) {
-  if (argc < 2) return -1;
+  Emulator::Options options;
+  std::string rom_path;
+  bool has_fault_policy = false;
+  std::size_t session_count = 0;
+  Explorer::Options explorer_options;
+  std::string score_target;
+  bool is_exploring = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+
+    if (argument == "--debug") {
+#ifdef CHIP8_DEBUGGER
+      options.is_debugging = true;
+#else
+      std::cerr << "Debugger was compiled out of this build\n";
+#endif
+    } else if (argument == "--export-shm" && i + 1 < argc) {
+#ifdef CHIP8_SHARED_STATE
+      options.shared_state_name = argv[++i];
+#else
+      i++;
+      std::cerr << "Shared memory export is not supported in this build\n";
+#endif
+    } else if (argument == "--telemetry" && i + 1 < argc) {
+      options.telemetry_path = argv[++i];
+    } else if (argument == "--overlay") {
+      options.is_showing_overlay = true;
+    } else if (argument == "--perf") {
+      options.is_counting_perf = true;
+    } else if (argument == "--sessions" && i + 1 < argc) {
+      session_count = std::stoul(argv[++i]);
+    } else if (argument == "--explore" && i + 1 < argc) {
+      explorer_options.depth = std::stoul(argv[++i]);
+      is_exploring = true;
+    } else if (argument == "--explore-width" && i + 1 < argc) {
+      explorer_options.beam_width = std::stoul(argv[++i]);
+    } else if (argument == "--score" && i + 1 < argc) {
+      score_target = argv[++i];
+    } else if (argument == "--on-fault" && i + 1 < argc) {
+      std::string fault_policy = argv[++i];
+      has_fault_policy = true;
+
+      if (fault_policy == "halt") {
+        options.fault_policy = Processor::FaultPolicy::HALT;
+      } else if (fault_policy == "ignore") {
+        options.fault_policy = Processor::FaultPolicy::IGNORE;
+      } else if (fault_policy == "break") {
+        options.fault_policy = Processor::FaultPolicy::BREAK;
+      } else {
+        std::cerr << "Fault policy should be one of halt, ignore or break\n";
+        return -1;
+      }
+    } else {
+      rom_path = argument;
+    }
+  }
+
+  if (rom_path.empty()) return -1;
+  if (session_count > 0) return runSessions(rom_path, session_count);
+  if (is_exploring) {
+    if (score_target.empty()) {
+      std::cerr << "--explore needs a --score target (Vx or a hex address)\n";
+      return -1;
+    }
+
+    try {
+      return runExplorer(rom_path, explorer_options, score_target);
+    } catch (const std::exception& exception) {
+      std::cerr << exception.what() << "\n";
+      return -1;
+    }
+  }
+
+  // Faults break into the debugger by default when there is one
+  if (options.is_debugging && !has_fault_policy) {
+    options.fault_policy = Processor::FaultPolicy::BREAK;
+  }
 
-  std::string rom_path = argv[1];
-  Emulator emulator{rom_path};
-  emulator.start();
+  try {
+    Emulator emulator{rom_path, options};
+    emulator.start();
+  } catch (const std::exception& exception) {
+    std::cerr << exception.what() << "\n";
+    return -1;
+  }
 
   return 0;
 }